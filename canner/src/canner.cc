@@ -20,10 +20,19 @@
 
 #include <array>
 #include <bitset>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <getopt.h>
 #include <iostream>
 #include <limits>
+#include <list>
+#include <map>
+#include <sstream>
+#include <strings.h>
 #include <tuple>
 #include <unistd.h>
 #include <unordered_map>
@@ -37,6 +46,8 @@
 
 #include "yaml-cpp/yaml.h"
 
+#include "dfa.h"
+
 using swoc::Errata;
 using swoc::Severity;
 using swoc::TextView;
@@ -66,8 +77,18 @@ namespace
 const std::string REF_KEY{"$ref"};
 
 // Command line options.
-std::array<option, 4> Options = {
-  {{"hdr", 1, nullptr, 'h'}, {"src", 1, nullptr, 's'}, {"class", 1, nullptr, 'c'}, {nullptr, 0, nullptr, 0}}};
+std::array<option, 6> Options = {{{"hdr", 1, nullptr, 'h'},
+                                   {"src", 1, nullptr, 's'},
+                                   {"class", 1, nullptr, 'c'},
+                                   {"memo", 0, nullptr, 'm'},
+                                   {"include", 1, nullptr, 'i'},
+                                   {nullptr, 0, nullptr, 0}}};
+
+/// Parameter list of generated validation functions.
+/// Any parameter may be unused, e.g. @a erratum is used only by combinators and custom checks and
+/// @a node is not used for an empty schema.
+constexpr std::string_view VALIDATOR_SIGNATURE{"([[maybe_unused]] swoc::Errata &erratum, [[maybe_unused]] YAML::Node const& node, "
+                                               "[[maybe_unused]] std::string_view const& name)"};
 
 /// JSON Schema types.
 enum class SchemaType { NIL, BOOL, OBJECT, ARRAY, NUMBER, INTEGER, STRING, INVALID };
@@ -102,17 +123,75 @@ std::map<SchemaType, std::string_view> SchemaTypeCheck{{
   {SchemaType::STRING, "is_string_type"},
 }};
 
+/// String formats.
+enum class Format { IPV4, IPV6, IP_ADDRESS, IP_RANGE, CIDR, HOSTNAME, FQDN, URI, URI_REFERENCE, INVALID };
+
+swoc::Lexicon<Format> FormatName{{
+  {Format::IPV4, "ipv4"},
+  {Format::IPV6, "ipv6"},
+  {Format::IP_ADDRESS, "ip-address"},
+  {Format::IP_RANGE, "ip-range"},
+  {Format::CIDR, "cidr"},
+  {Format::HOSTNAME, "hostname"},
+  {Format::FQDN, "fqdn"},
+  {Format::URI, "uri"},
+  {Format::URI_REFERENCE, "uri-reference"},
+}};
+
+// Format check functions, injected in to the generated file.
+std::map<Format, std::string_view> FormatCheck{{
+  {Format::IPV4, "is_ipv4_format"},
+  {Format::IPV6, "is_ipv6_format"},
+  {Format::IP_ADDRESS, "is_ip_address_format"},
+  {Format::IP_RANGE, "is_ip_range_format"},
+  {Format::CIDR, "is_cidr_format"},
+  {Format::HOSTNAME, "is_hostname_format"},
+  {Format::FQDN, "is_fqdn_format"},
+  {Format::URI, "is_uri_format"},
+  {Format::URI_REFERENCE, "is_uri_reference_format"},
+}};
+
 // Supported properties in the schema. All properties should be listed here.
 enum class Property {
   TYPE,
   PROPERTIES,
   REQUIRED,
+  ADDITIONAL_PROPERTIES,
+  MIN_PROPERTIES,
+  MAX_PROPERTIES,
   ITEMS,
+  PREFIX_ITEMS,
+  ADDITIONAL_ITEMS,
   MIN_ITEMS,
   MAX_ITEMS,
+  UNIQUE_ITEMS,
+  UNIQUE_KEY,
   ONE_OF,
   ANY_OF,
+  ALL_OF,
+  NOT,
+  IF,
+  THEN,
+  ELSE,
   ENUM,
+  CONST,
+  IGNORE_CASE,
+  MINIMUM,
+  MAXIMUM,
+  EXCLUSIVE_MINIMUM,
+  EXCLUSIVE_MAXIMUM,
+  MULTIPLE_OF,
+  PATTERN,
+  MIN_LENGTH,
+  MAX_LENGTH,
+  PATTERN_PROPERTIES,
+  PROPERTY_NAMES,
+  DEPENDENT_REQUIRED,
+  DEPENDENT_SCHEMAS,
+  DEPENDENCIES,
+  DECODED_SIZE,
+  CHECK,
+  FORMAT,
   INVALID,
   // For looping over properties.
   BEGIN = PROPERTIES,
@@ -125,20 +204,60 @@ using PropertySet = std::bitset<int(Property::INVALID) + 1>;
 // Conversion between property type and the in schema string representation.
 swoc::Lexicon<Property> PropName{
   {Property::TYPE, "type"},    {Property::PROPERTIES, "properties"}, {Property::REQUIRED, "required"},
+  {Property::ADDITIONAL_PROPERTIES, "additionalProperties"},         {Property::MIN_PROPERTIES, "minProperties"},
+  {Property::MAX_PROPERTIES, "maxProperties"},
   {Property::ITEMS, "items"},  {Property::MIN_ITEMS, "minItems"},    {Property::MAX_ITEMS, "maxItems"},
-  {Property::ONE_OF, "oneOf"}, {Property::ANY_OF, "anyOf"},          {Property::ENUM, "enum"}};
+  {Property::UNIQUE_ITEMS, "uniqueItems"}, {Property::UNIQUE_KEY, "x-unique-key"},
+  {Property::PREFIX_ITEMS, "prefixItems"}, {Property::ADDITIONAL_ITEMS, "additionalItems"},
+  {Property::ONE_OF, "oneOf"}, {Property::ANY_OF, "anyOf"},          {Property::ENUM, "enum"},
+  {Property::ALL_OF, "allOf"}, {Property::NOT, "not"},               {Property::IF, "if"},
+  {Property::THEN, "then"},    {Property::ELSE, "else"},
+  {Property::CONST, "const"},  {Property::IGNORE_CASE, "x-ignore-case"},
+  {Property::MINIMUM, "minimum"},  {Property::MAXIMUM, "maximum"},
+  {Property::EXCLUSIVE_MINIMUM, "exclusiveMinimum"},  {Property::EXCLUSIVE_MAXIMUM, "exclusiveMaximum"},
+  {Property::MULTIPLE_OF, "multipleOf"}, {Property::PATTERN, "pattern"},
+  {Property::MIN_LENGTH, "minLength"}, {Property::MAX_LENGTH, "maxLength"},
+  {Property::PATTERN_PROPERTIES, "patternProperties"}, {Property::PROPERTY_NAMES, "propertyNames"},
+  {Property::DEPENDENT_REQUIRED, "dependentRequired"}, {Property::DEPENDENT_SCHEMAS, "dependentSchemas"},
+  {Property::DEPENDENCIES, "dependencies"}, {Property::DECODED_SIZE, "x-decoded-size"},
+  {Property::CHECK, "x-check"},
+  {Property::FORMAT, "format"}};
 
 // Lists of property names. There should be a list for each primary property, for which the list should
 // be those other properties that are valid only for the primary property.
-std::array<std::string_view, 2> ObjectPropNames = {{PropName[Property::PROPERTIES], PropName[Property::REQUIRED]}};
-std::array<std::string_view, 3> ArrayPropNames  = {
-  {PropName[Property::ITEMS], PropName[Property::MIN_ITEMS], PropName[Property::MAX_ITEMS]}};
+std::array<std::string_view, 11> ObjectPropNames = {{PropName[Property::PROPERTIES], PropName[Property::REQUIRED],
+                                                    PropName[Property::ADDITIONAL_PROPERTIES], PropName[Property::MIN_PROPERTIES],
+                                                    PropName[Property::MAX_PROPERTIES], PropName[Property::PATTERN_PROPERTIES],
+                                                    PropName[Property::PROPERTY_NAMES], PropName[Property::DEPENDENT_REQUIRED],
+                                                    PropName[Property::DEPENDENT_SCHEMAS], PropName[Property::DEPENDENCIES],
+                                                    PropName[Property::DECODED_SIZE]}};
+std::array<std::string_view, 7> ArrayPropNames  = {{PropName[Property::ITEMS], PropName[Property::PREFIX_ITEMS],
+                                                   PropName[Property::ADDITIONAL_ITEMS], PropName[Property::MIN_ITEMS],
+                                                   PropName[Property::MAX_ITEMS], PropName[Property::UNIQUE_ITEMS],
+                                                   PropName[Property::UNIQUE_KEY]}};
+std::array<std::string_view, 5> NumberPropNames = {{PropName[Property::MINIMUM], PropName[Property::MAXIMUM],
+                                                   PropName[Property::EXCLUSIVE_MINIMUM], PropName[Property::EXCLUSIVE_MAXIMUM],
+                                                   PropName[Property::MULTIPLE_OF]}};
+std::array<std::string_view, 2> StringPropNames = {{PropName[Property::MIN_LENGTH], PropName[Property::MAX_LENGTH]}};
+
+// Annotation tags - these have no effect on validation.
+std::array<std::string_view, 5> AnnotationNames = {{"description", "title", "$comment", "default", "examples"}};
+
+/// Count the tags in a schema @a node that affect validation.
+size_t
+validation_tag_count(YAML::Node const &node)
+{
+  return std::count_if(node.begin(), node.end(), [](auto const &pair) {
+    return AnnotationNames.end() == std::find(AnnotationNames.begin(), AnnotationNames.end(), pair.first.Scalar());
+  });
+}
 
 // File scope initializations.
 [[maybe_unused]] bool INITIALIZED = (
 
   SchemaTypeLexicon.set_default(SchemaType::INVALID).set_default("INVALID"),
   PropName.set_default(Property ::INVALID).set_default("INVALID"),
+  FormatName.set_default(Format::INVALID).set_default("INVALID"),
 
   // The set of type strings doesn't change, set up a global with the list.
   []() -> void {
@@ -151,6 +270,67 @@ std::array<std::string_view, 3> ArrayPropNames  = {
   }(),
   true);
 
+/** Structural hash of a node.
+ *
+ * Scalars hash by content, sequences by their items in order, and maps by their key / value pairs
+ * without regard to order. This must be kept identical to the @c node_hash injected in to the
+ * generated code, as the hashes of enumeration values are computed here and compared there.
+ */
+uint64_t
+hash_mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t
+node_hash(YAML::Node const &node)
+{
+  switch (node.Type()) {
+  case YAML::NodeType::Scalar: {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : node.Scalar()) {
+      h = (h ^ c) * 0x100000001b3ULL;
+    }
+    return hash_mix(h);
+  }
+  case YAML::NodeType::Sequence: {
+    uint64_t h = 3;
+    for (auto const &n : node) {
+      h = hash_mix(h + node_hash(n));
+    }
+    return h;
+  }
+  case YAML::NodeType::Map: {
+    uint64_t h = 0;
+    for (auto const &pair : node) {
+      h += hash_mix(node_hash(pair.first) * 31 + node_hash(pair.second));
+    }
+    return hash_mix(h ^ 4);
+  }
+  default:
+    break;
+  }
+  return hash_mix(1);
+}
+
+/// Generate a C++ character literal for @a c.
+std::string
+char_literal(char c)
+{
+  std::string zret;
+  if (isprint(static_cast<unsigned char>(c)) && c != '\'' && c != '\\') {
+    swoc::bwprint(zret, "'{}'", c);
+  } else {
+    swoc::bwprint(zret, "'\\x{:02x}'", static_cast<unsigned>(static_cast<unsigned char>(c)));
+  }
+  return zret;
+}
+
 }; // namespace
 
 namespace YAML
@@ -219,16 +399,45 @@ struct Context {
   std::ofstream src_file; ///< File object for the generated source file.
   std::string class_name; ///< Class name of the generated class.
   Errata notes;           ///< Errors / notes encountered during parsing.
+  bool memo_p{false};     ///< Memoize definition results per node.
+  bool ip_format_p{false}; ///< IP address formats are used.
+  bool text_format_p{false}; ///< Host name or URI formats are used.
+  bool decoded_size_p{false}; ///< Decoded size checks are used.
+  std::vector<std::string> includes; ///< User headers that declare custom check functions.
+  bool check_p{false};               ///< Custom check functions are used.
 
-  int _src_indent{0};    ///< Indent level of the generated source file.
-  bool _src_sol_p{true}; ///< (at) start of line flag for generated source file.
   int _hdr_indent{0};    ///< Indent level of the header file.
   bool _hdr_sol_p{true}; /// (at) start of line flag for generated header file.
 
+  /// Source text for a generated function. Functions are generated while generating other
+  /// functions (e.g. the branches of 'anyOf') and so the text for each is accumulated separately
+  /// and moved to the function definitions when complete.
+  struct SrcFrame {
+    std::string name;        ///< Function name.
+    std::ostringstream text; ///< Generated source text.
+    int indent{0};           ///< Indent level.
+    bool sol_p{true};        ///< (at) start of line flag.
+    /// Validity flags of the nodes being generated that have custom checks, which are cleared by an
+    /// item or property that fails without stopping validation.
+    std::vector<std::string> node_valid;
+  };
+  /// Stack of generated functions. The bottom frame is file scope text after the functions.
+  std::list<SrcFrame> _src_frames{1};
+  std::ostringstream _src_decls; ///< Declarations of generated functions.
+  std::ostringstream _src_defs;  ///< Definitions of generated functions.
+
   /// Generated variable name index. This enables generating unique names whenever a local node
   /// variable is required.
   int var_idx{1};
 
+  /// Map of pattern sets to matcher functions, so each distinct set is compiled once.
+  std::map<std::string, std::string> matchers;
+
+  /// Messages for generated errors, indexed by error code. See @c emit_error for the format.
+  std::vector<std::string> messages;
+  /// Schema locations of generated errors - the line of the schema node and text for the message.
+  std::vector<std::pair<int, std::string>> locations;
+
   /// Map of local definition URIs. When a '$ref' is found, this table is consulted to find the
   /// correct validation function to invoke.
   using Definitions = std::unordered_map<std::string, std::string>;
@@ -237,6 +446,50 @@ struct Context {
   /// Allocate a new variable name.
   std::string var_name();
 
+  /// Allocate a new function name for the @a tag validator in the current function.
+  std::string fn_name(std::string_view tag);
+
+  /** Start generating a validation function.
+   *
+   * @param name Name of the function.
+   *
+   * The function has internal linkage and is declared before any function definition so that it
+   * can be called directly from any other generated function. Source output is directed to the
+   * body of the function until @c end_validator is called.
+   */
+  void begin_validator(std::string const &name);
+  /// Finish the current validation function.
+  void end_validator();
+  /// Emit a call to validation function @a fn for node @a var, returning on failure.
+  void emit_validator_call(std::string_view const &fn, std::string_view const &var);
+  /** Start the checks for an item or property of a container.
+   *
+   * The checks are in a lambda so that a failure returns from the item only. The fast variant then
+   * returns failure, the diagnostic variant continues with the next item if the error budget allows.
+   */
+  void begin_item();
+  /// Finish the checks for an item or property.
+  void end_item();
+  /** Emit an error report for node @a var and return failure.
+   *
+   * @param msg Message format.
+   * @param schema Schema node for the check.
+   * @param text Schema text for the message.
+   * @param var Expression for the invalid node.
+   * @param arg_0 Expression for the first numeric argument.
+   * @param arg_1 Expression for the second numeric argument.
+   *
+   * Only the message index, the schema location and the arguments are stored in the generated code,
+   * the message is rendered from the table when the error is read. The arguments for @a msg are the
+   * instance path, the node line, @a text, the node value, the numeric arguments and the schema line.
+   */
+  void emit_error(std::string_view msg, YAML::Node const &schema, std::string_view text, std::string_view var,
+                  std::string_view arg_0 = "0", std::string_view arg_1 = "0");
+  /// Get the error code for message @a msg.
+  unsigned error_code(std::string_view msg);
+  /// Get the location id for the check for @a schema with message text @a text.
+  unsigned location(YAML::Node const &schema, std::string_view text);
+
   void indent_src(); ///< Increase the indent level of the generated source file.
   void exdent_src(); ///< Decrease the indent level of the generated source file.
   void indent_hdr(); ///< Increase the indent level of the generated header file.
@@ -251,25 +504,199 @@ struct Context {
    */
   Rv<YAML::Node> locate(YAML::Node base, TextView path);
 
+  /// Follow '$ref' tags from @a node to the schema that is used for validation.
+  YAML::Node resolve(YAML::Node node);
+
+  /** Conditions that are necessary for a node to be valid for a schema.
+   *
+   * These are used to select the branches of a combinator that could be valid for a node, which is
+   * much less expensive than validating the node against every branch.
+   */
+  struct BranchFilter {
+    /// Node types (as bits indexed by @c YAML::NodeType) that can be valid.
+    unsigned kinds = (1 << YAML::NodeType::Null) | (1 << YAML::NodeType::Scalar) | (1 << YAML::NodeType::Sequence) |
+                     (1 << YAML::NodeType::Map);
+    std::vector<std::string> required; ///< Keys required if the node is a map.
+    /// Scalar values allowed for a key, if present.
+    std::map<std::string, std::vector<std::string>> values;
+    bool closed_p = false;         ///< Only keys in @a keys are valid.
+    std::vector<std::string> keys; ///< Property keys, if @a closed_p.
+  };
+  /// Compute the filter for the schema @a node.
+  BranchFilter branch_filter(YAML::Node const &node);
+  /** Emit the selection of combinator branches for node @a var.
+   *
+   * @param branches Schemas for the branches.
+   * @param var Name of the node.
+   *
+   * This emits the declaration of a bit mask "candidates" which has a bit set for each branch which
+   * could be valid. If no branch could be valid, all bits are set so that full diagnostics are generated.
+   *
+   * @return @c true if the mask was emitted, @c false if there are too many branches to track.
+   */
+  bool emit_branch_select(YAML::Node const &branches, std::string_view const &var);
+  /// Emit a bit set constant @a name with the bits @a bits set.
+  void emit_bitset_const(std::string_view const &name, size_t n, std::vector<size_t> const &bits);
+
   // Working methods.
   Errata process_definitions(YAML::Node const& node);
   /// Generate validation logic for a specific node.
   Errata validate_node(YAML::Node const &node, std::string_view const &var);
 
+  /** Load a count value.
+   *
+   * @param node Schema node.
+   * @param prop Property for the count.
+   * @param count [out] The count value, unchanged if @a prop is not present.
+   */
+  Errata load_count(YAML::Node const &node, Property prop, int &count);
+
+  /// A numeric value from the schema.
+  struct Number {
+    bool int_p{false}; ///< Integral value, @a i is valid.
+    int64_t i{0};      ///< Integer value.
+    double d{0};       ///< Floating point value.
+    std::string text;  ///< Value as a C++ literal.
+  };
+  /** Load a numeric value.
+   *
+   * @param node Schema node.
+   * @param prop Property for the value.
+   * @param number [out] The value.
+   */
+  Errata load_number(YAML::Node const &node, Property prop, Number &number);
+
   /// Process properties. Each function process the value for a specific property and is responsible
   /// for generating the appropriate code or dispatching the appropriate "emit_..." functions.
   Errata process_type_value(const YAML::Node &value, TypeSet &types);
   Errata process_object_value(YAML::Node const &node, std::string_view const &var, TypeSet const &types);
   Errata process_array_value(YAML::Node const &node, std::string_view const &var, TypeSet const &types);
+  /** Process positional item schemas.
+   *
+   * @param node Schema node for the array.
+   * @param tuple Schemas for the leading items.
+   * @param rest Schema for the other items, if defined.
+   * @param closed_p Other items are not allowed.
+   * @param var Name of the array node.
+   * @param max_items Maximum number of items in the array.
+   */
+  Errata process_tuple_value(YAML::Node const &node, YAML::Node const &tuple, YAML::Node const &rest, bool closed_p,
+                             std::string_view const &var, int max_items);
+  /** Process numeric properties.
+   *
+   * @param node Schema node.
+   * @param var Name of the instance node.
+   * @param value Name of the parsed scalar value for @a var.
+   * @param types Types valid for @a var.
+   */
+  Errata process_number_value(YAML::Node const &node, std::string_view const &var, std::string_view const &value, TypeSet const &types);
   Errata process_any_of_value(YAML::Node const &node, std::string_view const &var);
   Errata process_one_of_value(YAML::Node const &node, std::string_view const &var);
-  Errata process_enum_value(YAML::Node const &node, std::string_view const &var);
+  /** Generate a validation function for a branch of a schema combinator.
+   *
+   * @param node Schema for the branch.
+   * @param tag Tag for the generated function name.
+   * @param fn [out] Name of the validation function for the branch.
+   */
+  Errata process_branch(YAML::Node const &node, std::string_view const &tag, std::string &fn);
+  /** Merge the @c allOf branches of a schema.
+   *
+   * @param node Schema with an @c allOf.
+   * @param merged [out] @a node without the @c allOf with the branches merged in.
+   * @param rest [out] Branches that could not be merged.
+   *
+   * Merging means the branches share a single type check, key iteration and required key check
+   * instead of each branch traversing the node. Branches are merged when the combined schema is
+   * equivalent to the branches - e.g. @c required is the union and @c minItems the maximum. A branch
+   * that conflicts with the schema it would be merged in to is validated separately.
+   */
+  Errata merge_all_of(YAML::Node const &node, YAML::Node &merged, std::vector<YAML::Node> &rest);
+  Errata process_not_value(YAML::Node const &node, std::string_view const &var);
+  /** Process a conditional schema.
+   *
+   * @param node Schema with the @c if.
+   * @param var Name of the instance node.
+   */
+  Errata process_if_value(YAML::Node const &node, std::string_view const &var);
+  Errata process_enum_value(YAML::Node const &node, std::string_view const &var, bool nocase_p);
+  Errata process_const_value(YAML::Node const &node, std::string_view const &var, bool nocase_p);
+  /** Process string length properties.
+   *
+   * @param node Schema node.
+   * @param var Name of the instance node.
+   * @param types Types valid for @a var.
+   */
+  Errata process_string_value(YAML::Node const &node, std::string_view const &var, TypeSet const &types);
+  Errata process_pattern_value(YAML::Node const &node, std::string_view const &var);
+  Errata process_format_value(YAML::Node const &node, std::string_view const &var);
+  /** Process custom checks.
+   *
+   * @param node The check function name, or an array of names.
+   * @param var Name of the instance node.
+   *
+   * Check functions must have the same signature as generated validation functions and be declared
+   * in a header passed with the "--include" option.
+   */
+  Errata process_check_value(YAML::Node const &node, std::string_view const &var);
 
   /// Direct code generation. Each "emit_..." function emits validation code for a specific property.
-  void emit_type_check(TypeSet const &types, std::string_view const &var);
-  void emit_required_check(YAML::Node const &node, std::string_view const &var);
-  void emit_min_items_check(std::string_view const &var, uintmax_t limit);
-  void emit_max_items_check(std::string_view const &var, uintmax_t limit);
+  /** Emit the type check.
+   *
+   * @param schema Schema node.
+   * @param types Valid types.
+   * @param var Name of the node to check.
+   * @param mask Expression for the type mask of @a var, computed from @a var if empty.
+   */
+  void emit_type_check(YAML::Node const &schema, TypeSet const &types, std::string_view const &var, std::string_view const &mask = {});
+  /** Emit the check for required keys.
+   *
+   * @param schema Schema node.
+   * @param keys Keys tracked in the object key iteration.
+   * @param required Indices in @a keys of the required keys.
+   * @param seen Name of the bit set of keys present.
+   * @param var Name of the object node.
+   */
+  void emit_required_check(YAML::Node const &schema, std::vector<std::string> const &keys, std::vector<size_t> const &required,
+                           std::string_view const &seen, std::string_view const &var);
+  void emit_min_items_check(YAML::Node const &schema, std::string_view const &var, uintmax_t limit);
+  void emit_max_items_check(YAML::Node const &schema, std::string_view const &var, uintmax_t limit);
+  /** Emit the check for duplicate items.
+   *
+   * @param schema Schema node for the check.
+   * @param var Name of the array node.
+   * @param key Key of the object item property that must be unique, or empty to compare entire items.
+   */
+  void emit_unique_check(YAML::Node const &schema, std::string_view const &var, std::string_view const &key);
+  Errata emit_value_check(YAML::Node const &schema, std::vector<YAML::Node> const &values, std::string_view const &var, bool nocase_p,
+                          Property prop);
+  /** Emit a function that runs the automaton @a dfa.
+   *
+   * @param dfa The automaton.
+   * @param patterns The patterns in @a dfa, for documentation.
+   * @return The name of the function.
+   *
+   * The function takes a @c std::string_view and returns the accept mask for the final state.
+   */
+  std::string emit_matcher(Dfa const &dfa, std::vector<std::string> const &patterns);
+  /** Get the matcher function for a set of patterns, generating it if needed.
+   *
+   * @param patterns The patterns.
+   * @param name [out] Name of the matcher function.
+   */
+  Errata matcher(std::vector<std::string> const &patterns, std::string &name);
+
+  /** Emit a dispatch of a string view against a fixed set of strings.
+   *
+   * @param values The strings to match against.
+   * @param var Name of the @c std::string_view in the generated code.
+   * @param nocase_p Compare without regard to (ASCII) case.
+   * @param on_match Functor invoked with the index in @a values to emit the code for that match.
+   *
+   * The generated code switches on the size and then on character positions that distinguish the
+   * candidates, so at most one full comparison is done. No parsing or allocation is done at run time.
+   */
+  template <typename F>
+  void emit_string_dispatch(std::vector<std::string> const &values, std::string_view const &var, bool nocase_p, F const &on_match);
 
   /// Output. These functions send text to the generated source and header files respectively.
   /// Internally the text is checked for new lines and the approrpriate indentation is applied.
@@ -278,7 +705,7 @@ struct Context {
 
   /// Internal output functions which does the real work. @c src_out and @c hdr_out are responsible
   /// for passing the appropriate arguments to this method to send the output to the right place.
-  void out(std::ofstream &s, TextView text, bool &sol_p, int indent);
+  void out(std::ostream &s, TextView text, bool &sol_p, int indent);
 };
 
 void
@@ -289,7 +716,7 @@ Context::exdent_hdr()
 void
 Context::exdent_src()
 {
-  --_src_indent;
+  --_src_frames.back().indent;
 }
 void
 Context::indent_hdr()
@@ -299,7 +726,7 @@ Context::indent_hdr()
 void
 Context::indent_src()
 {
-  ++_src_indent;
+  ++_src_frames.back().indent;
 }
 
 template <typename... Args>
@@ -308,7 +735,8 @@ Context::src_out(std::string_view fmt, Args &&... args)
 {
   static std::string tmp; // static makes for better memory reuse.
   swoc::bwprint_v(tmp, fmt, std::forward_as_tuple(args...));
-  this->out(src_file, tmp, _src_sol_p, _src_indent);
+  auto &frame = _src_frames.back();
+  this->out(frame.text, tmp, frame.sol_p, frame.indent);
 }
 
 template <typename... Args>
@@ -321,7 +749,7 @@ Context::hdr_out(std::string_view fmt, Args &&... args)
 }
 
 void
-Context::out(std::ofstream &s, TextView text, bool &sol_p, int indent)
+Context::out(std::ostream &s, TextView text, bool &sol_p, int indent)
 {
   while (text) {
     auto n    = text.size();
@@ -357,83 +785,275 @@ Context::var_name()
   return std::move(var);
 }
 
+std::string
+Context::fn_name(std::string_view tag)
+{
+  std::string name;
+  swoc::bwprint(name, "{}_{}_{}", _src_frames.back().name, tag, var_idx++);
+  return name;
+}
+
 void
-Context::emit_min_items_check(std::string_view const &var, uintmax_t limit)
+Context::begin_validator(std::string const &name)
 {
-  src_out("if ({}.size() < {}) {{ erratum.error(\"Array at line {{}} has only "
-          "{{}} items instead of the required {} items\", {}.Mark().line, "
-          "{}.size()); return false; }}\n",
-          var, limit, limit, var, var);
+  std::string tmp;
+  _src_decls << swoc::bwprint(tmp, "template <bool DIAG> bool {}{};\n", name, VALIDATOR_SIGNATURE);
+  auto &frame = _src_frames.emplace_back();
+  frame.name  = name;
+  src_out("template <bool DIAG>\nbool {}{} {{\n", name, VALIDATOR_SIGNATURE);
+  indent_src();
+  src_out("[[maybe_unused]] bool valid_p = true;\n");
 }
 
 void
-Context::emit_max_items_check(std::string_view const &var, uintmax_t limit)
+Context::end_validator()
 {
-  src_out("if ({}.size() > {}) {{ erratum.error(\"Array at line {{}} has {{}} "
-          "items instead of the maximum {} items\", {}.Mark().line, "
-          "{}.size()); return false; }}\n",
-          var, limit, limit, var, var);
+  src_out("return valid_p;\n");
+  exdent_src();
+  src_out("}}\n\n");
+  _src_defs << _src_frames.back().text.str();
+  _src_frames.pop_back();
 }
 
 void
-Context::emit_required_check(YAML::Node const &node, std::string_view const &var)
+Context::emit_validator_call(std::string_view const &fn, std::string_view const &var)
 {
-  src_out("// check for required tags\nfor ( auto && tag : {{ ");
-  TextView delimiter;
-  for (auto &&n : node) {
-    src_out(R"non({}"{}")non", delimiter, n.Scalar());
-    delimiter.assign(", ");
-  }
-  src_out(" }} ) {{\n");
-  indent_src();
-  src_out("if (!{}[tag]) {{\n", var);
+  src_out("if (! {}<DIAG>(erratum, {}, name)) return false;\n", fn, var);
+}
+
+void
+Context::begin_item()
+{
+  src_out("if (! [&]() -> bool {{\n");
   indent_src();
-  src_out("erratum.error(\"Required tag '{{}}' at line {{}} was not found.\", "
-          "tag, {}.Mark().line);\nreturn false;\n",
-          var);
+}
+
+void
+Context::end_item()
+{
+  src_out("return true;\n");
   exdent_src();
-  src_out("}}\n");
+  src_out("}}()) {{\n");
+  indent_src();
+  src_out("if (! keep_going<DIAG>()) return false;\nvalid_p = false;\n");
+  for (auto const &flag : _src_frames.back().node_valid) {
+    src_out("{} = false;\n", flag);
+  }
   exdent_src();
   src_out("}}\n");
 }
 
 void
-Context::emit_type_check(TypeSet const &types, std::string_view const &var)
+Context::emit_error(std::string_view msg, YAML::Node const &schema, std::string_view text, std::string_view var,
+                    std::string_view arg_0, std::string_view arg_1)
 {
-  TextView delimiter;
+  src_out("if constexpr (DIAG) report({}, {}, {}, {}, {});\nreturn false;\n", error_code(msg), location(schema, text), var, arg_0,
+          arg_1);
+}
 
-  src_out("// validate value type\n");
-  src_out("if (! ");
-  if (types.count() == 1) {
-    auto &&[value, name] = *std::find_if(SchemaTypeLexicon.begin(), SchemaTypeLexicon.end(),
-                                         [&](auto &&v) -> bool { return types[int(std::get<0>(v))]; });
-    src_out("{}({})) {{ erratum.error(\"'{{}}' value at line {{}} was not {}\", name, "
-            "{}.Mark().line); return false; }}\n",
-            SchemaTypeCheck[value], var, name, var);
-  } else {
-    src_out("(");
-    for (auto &&[value, func] : SchemaTypeCheck) {
-      if (types[int(value)]) {
-        src_out("{}{}({})", delimiter, func, var);
-        delimiter.assign(" || ");
+unsigned
+Context::error_code(std::string_view msg)
+{
+  auto spot = std::find(messages.begin(), messages.end(), msg);
+  if (spot == messages.end()) {
+    messages.emplace_back(msg);
+    return messages.size() - 1;
+  }
+  return spot - messages.begin();
+}
+
+unsigned
+Context::location(YAML::Node const &schema, std::string_view text)
+{
+  auto line = schema.Mark().line;
+  auto spot = std::find_if(locations.begin(), locations.end(), [&](auto const &loc) { return loc.first == line && loc.second == text; });
+  if (spot == locations.end()) {
+    locations.emplace_back(line, text);
+    return locations.size() - 1;
+  }
+  return spot - locations.begin();
+}
+
+template <typename F>
+void
+Context::emit_string_dispatch(std::vector<std::string> const &values, std::string_view const &var, bool nocase_p, F const &on_match)
+{
+  auto fold = [=](char c) -> char { return nocase_p && 'A' <= c && c <= 'Z' ? c + ('a' - 'A') : c; };
+
+  // Recursively split a group of same sized values on the character position that best
+  // distinguishes them until each group has a single member.
+  std::function<void(std::vector<size_t> const &, std::vector<bool> &)> split;
+  split = [&](std::vector<size_t> const &group, std::vector<bool> &used) -> void {
+    auto size = values[group.front()].size();
+    size_t best_pos = size;
+    std::map<char, std::vector<size_t>> best;
+    for (size_t pos = 0; pos < size; ++pos) {
+      if (!used[pos]) {
+        std::map<char, std::vector<size_t>> parts;
+        for (auto idx : group) {
+          parts[fold(values[idx][pos])].push_back(idx);
+        }
+        if (parts.size() > best.size()) {
+          best_pos = pos;
+          best     = std::move(parts);
+        }
       }
     }
 
-    src_out(")) {{\n");
-    indent_src();
-    src_out("erratum.error(\"value at line {{}} was not one of the "
-            "required types ");
-    delimiter.clear();
-    for (auto [value, name] : SchemaTypeLexicon) {
-      if (types[int(value)]) {
-        src_out("{}'{}'", delimiter, name);
-        delimiter.assign(", ");
+    if (best.size() <= 1) { // No further distinction possible, compare the full string.
+      for (auto idx : group) {
+        if (size == 0) {
+          src_out("{{\n");
+        } else if (nocase_p) {
+          src_out("if (0 == strncasecmp({}.data(), R\"uthira({})uthira\", {})) {{\n", var, values[idx], size);
+        } else {
+          src_out("if (0 == memcmp({}.data(), R\"uthira({})uthira\", {})) {{\n", var, values[idx], size);
+        }
+        indent_src();
+        on_match(idx);
+        exdent_src();
+        src_out("}}\n");
+      }
+      return;
+    }
+
+    used[best_pos] = true;
+    src_out("switch ({}[{}]) {{\n", var, best_pos);
+    for (auto &&[c, part] : best) {
+      src_out("case {}:\n", char_literal(c));
+      if (nocase_p && 'a' <= c && c <= 'z') {
+        src_out("case {}:\n", char_literal(c - ('a' - 'A')));
       }
+      indent_src();
+      split(part, used);
+      src_out("break;\n");
+      exdent_src();
     }
-    src_out("\");\nreturn false;\n");
+    src_out("}}\n");
+    used[best_pos] = false;
+  };
+
+  std::map<size_t, std::vector<size_t>> by_size;
+  for (size_t idx = 0; idx < values.size(); ++idx) {
+    by_size[values[idx].size()].push_back(idx);
+  }
+
+  src_out("switch ({}.size()) {{\n", var);
+  for (auto &&[size, group] : by_size) {
+    std::vector<bool> used(size, false);
+    src_out("case {}:\n", size);
+    indent_src();
+    split(group, used);
+    src_out("break;\n");
+    exdent_src();
+  }
+  src_out("}}\n");
+}
+
+void
+Context::emit_min_items_check(YAML::Node const &schema, std::string_view const &var, uintmax_t limit)
+{
+  std::string arg;
+  src_out("if ({}.size() < {}) {{\n", var, limit);
+  indent_src();
+  emit_error("Array '#{0}' at line {1} has only {4} items instead of the required {5} items.", schema, {}, var,
+             swoc::bwprint(arg, "{}.size()", var), std::to_string(limit));
+  exdent_src();
+  src_out("}}\n");
+}
+
+void
+Context::emit_max_items_check(YAML::Node const &schema, std::string_view const &var, uintmax_t limit)
+{
+  std::string arg;
+  src_out("if ({}.size() > {}) {{\n", var, limit);
+  indent_src();
+  emit_error("Array '#{0}' at line {1} has {4} items instead of the maximum {5} items.", schema, {}, var,
+             swoc::bwprint(arg, "{}.size()", var), std::to_string(limit));
+  exdent_src();
+  src_out("}}\n");
+}
+
+void
+Context::emit_unique_check(YAML::Node const &schema, std::string_view const &var, std::string_view const &key)
+{
+  std::string dup, first;
+  src_out("if (auto [first, dup] = find_duplicate({}, R\"uthira({})uthira\"); dup > 0) {{\n", var, key);
+  indent_src();
+  if (key.empty()) {
+    emit_error("Array '#{0}' at line {1} has a duplicate item at line {4} - first at line {5}.", schema, {}, var,
+               swoc::bwprint(dup, "{}[dup].Mark().line", var), swoc::bwprint(first, "{}[first].Mark().line", var));
+  } else {
+    emit_error("Array '#{0}' at line {1} has a duplicate '{2}' value at line {4} - first at line {5}.", schema, key, var,
+               swoc::bwprint(dup, "{}[dup][\"{}\"].Mark().line", var, key),
+               swoc::bwprint(first, "{}[first][\"{}\"].Mark().line", var, key));
+  }
+  exdent_src();
+  src_out("}}\n");
+}
+
+void
+Context::emit_bitset_const(std::string_view const &name, size_t n, std::vector<size_t> const &bits)
+{
+  std::string mask(n, '0');
+  for (auto idx : bits) {
+    mask[n - 1 - idx] = '1';
+  }
+  if (n <= std::numeric_limits<unsigned long long>::digits) {
+    src_out("static constexpr std::bitset<{}> {}{{0x{:x}ULL}};\n", n, name,
+            std::bitset<std::numeric_limits<unsigned long long>::digits>(mask).to_ullong());
+  } else {
+    src_out("static const std::bitset<{}> {}{{\"{}\"}};\n", n, name, mask);
+  }
+}
+
+void
+Context::emit_required_check(YAML::Node const &schema, std::vector<std::string> const &keys, std::vector<size_t> const &required,
+                             std::string_view const &seen, std::string_view const &var)
+{
+  src_out("// check for required tags\n");
+  emit_bitset_const("required_mask", keys.size(), required);
+  src_out("if (({} & required_mask) != required_mask) {{\n", seen);
+  indent_src();
+  for (auto idx : required) {
+    src_out("if (!{}[{}]) {{\n", seen, idx);
+    indent_src();
+    std::string text;
+    emit_error("Required tag {2} was not found in the object '#{0}' at line {1}.", schema, swoc::bwprint(text, "'{}'", keys[idx]), var);
     exdent_src();
     src_out("}}\n");
   }
+  exdent_src();
+  src_out("}}\n");
+}
+
+void
+Context::emit_type_check(YAML::Node const &schema, TypeSet const &types, std::string_view const &var, std::string_view const &mask)
+{
+  TextView delimiter;
+  std::string text;
+
+  src_out("// validate value type\n");
+  // The node is classified once and checked against all of the types at the same time.
+  if (mask.empty()) {
+    src_out("if (! (type_mask({}) & 0x{:x})) ", var, types.to_ulong());
+  } else {
+    src_out("if (! ({} & 0x{:x})) ", mask, types.to_ulong());
+  }
+  if (types.count() > 1) {
+    text = "one of the required types ";
+  }
+  for (auto [value, name] : SchemaTypeLexicon) {
+    if (types[int(value)]) {
+      text.append(delimiter).append("'").append(name).append("'");
+      delimiter.assign(", ");
+    }
+  }
+  src_out("{{\n");
+  indent_src();
+  emit_error("'#{0}' value at line {1} was not {2}.", schema, text, var);
+  exdent_src();
+  src_out("}}\n");
 }
 
 // Process a 'type' node.
@@ -471,42 +1091,41 @@ Context::process_any_of_value(YAML::Node const &node, std::string_view const &va
 {
   Errata zret;
   if (!node.IsSequence()) {
-    return zret.error("'{}' value at line {} is invalid - it must be {} type.", node.Mark().line,
+    return zret.error("'{}' value at line {} is invalid - it must be {} type.", PropName[Property::ANY_OF], node.Mark().line,
                       SchemaTypeLexicon[SchemaType::ARRAY]);
   } else if (node.size() < 1) {
     zret.warn("'{}' value at line {} has no items - ignored.", PropName[Property::ANY_OF], node.Mark().line);
   } else {
-    auto nvar = var_name();
-    std::string_view comma;
-    src_out("// {}\nswoc::Errata any_of_err;\nstd::array<Validator, {}> "
-            "any_of_verify = {{\n",
-            PropName[Property::ANY_OF], node.size());
-    indent_src();
+    std::vector<std::string> branches;
     for (auto &&schema : node) {
-      src_out("[&erratum = any_of_err, name, this] (YAML::Node const& node) -> bool {{\n");
-      indent_src();
-      auto r = validate_node(schema, "node");
-      if (!r.empty()) {
-        zret.note(r);
-        zret.note(r.severity(), "Processing '{}' value at line '{}'", PropName[Property::ANY_OF], node.Mark().line);
-        if (zret.severity() >= Severity::ERROR) {
-          return zret;
-        }
+      auto &fn = branches.emplace_back();
+      if (zret.note(this->process_branch(schema, "any_of", fn)).severity() >= Severity::ERROR) {
+        zret.note(zret.severity(), "Processing '{}' value at line '{}'", PropName[Property::ANY_OF], node.Mark().line);
+        return zret;
       }
-      src_out("return true;\n");
-      exdent_src();
-      src_out("}},\n");
     }
-    exdent_src();
-    src_out("}};\n");
-    src_out("if (! std::any_of(any_of_verify.begin(), any_of_verify.end(), "
-            "[&] (Validator const& vf) {{ return vf({}); }})) {{\n",
-            var);
+    src_out("// {}\n{{\n", PropName[Property::ANY_OF]);
+    indent_src();
+    bool select_p = emit_branch_select(node, var);
+    // Errors from the branches are kept only if no branch is valid.
+    src_out("swoc::Errata any_of_err;\n[[maybe_unused]] auto error_mark = begin_branches<DIAG>();\nbool any_of_p = ");
+    TextView delimiter;
+    for (unsigned idx = 0; idx < branches.size(); ++idx) {
+      if (select_p) {
+        src_out("{}((candidates & 0x{:x}) && branch_call(&{}<DIAG>, any_of_err, {}, name))", delimiter, 1U << idx, branches[idx],
+                var);
+      } else {
+        src_out("{}branch_call(&{}<DIAG>, any_of_err, {}, name)", delimiter, branches[idx], var);
+      }
+      delimiter.assign(" || ");
+    }
+    src_out(";\nif constexpr (DIAG) end_branches(error_mark, !any_of_p);\n");
+    src_out("if (!any_of_p) {{\n");
     indent_src();
-    src_out("erratum.note(any_of_err);\nerratum.error(\"Node at line {{}} was "
-            "not valid for any of these schemas.\", "
-            "{}.Mark().line);\nreturn false;\n",
-            var);
+    src_out("if constexpr (DIAG) erratum.note(any_of_err);\n");
+    emit_error("Node '#{0}' at line {1} was not valid for any of these schemas.", node, {}, var);
+    exdent_src();
+    src_out("}}\n");
     exdent_src();
     src_out("}}\n");
   }
@@ -516,591 +1135,3365 @@ Context::process_any_of_value(YAML::Node const &node, std::string_view const &va
 Errata
 Context::process_one_of_value(YAML::Node const &node, std::string_view const &var)
 {
+  Errata zret;
   if (!node.IsSequence()) {
-    return notes.error("'{}' value at line {} is invalid - it must be {} type.", node.Mark().line,
-                       SchemaTypeLexicon[SchemaType::ARRAY]);
+    return zret.error("'{}' value at line {} is invalid - it must be {} type.", PropName[Property::ONE_OF], node.Mark().line,
+                      SchemaTypeLexicon[SchemaType::ARRAY]);
   } else if (node.size() < 1) {
-    notes.warn("'{}' value at line {} has no items - ignored.", PropName[Property::ONE_OF], node.Mark().line);
+    zret.warn("'{}' value at line {} has no items - ignored.", PropName[Property::ONE_OF], node.Mark().line);
   } else {
-    auto nvar = var_name();
-    src_out("// {}\nswoc::Errata one_of_err;\nstd::array<Validator, {}> "
-            "one_of_verify = {{\n",
-            PropName[Property::ONE_OF], node.size());
-    indent_src();
+    std::vector<std::string> branches;
     for (auto &&schema : node) {
-      src_out("[&erratum = one_of_err, name, this] (YAML::Node const& node) -> bool {{\n");
+      auto &fn = branches.emplace_back();
+      if (zret.note(this->process_branch(schema, "one_of", fn)).severity() >= Severity::ERROR) {
+        zret.note(zret.severity(), "Processing '{}' value at line '{}'", PropName[Property::ONE_OF], node.Mark().line);
+        return zret;
+      }
+    }
+    src_out("// {}\n{{\n", PropName[Property::ONE_OF]);
+    indent_src();
+    bool select_p = emit_branch_select(node, var);
+    src_out("swoc::Errata one_of_err;\nunsigned one_of_count = 0;\n[[maybe_unused]] auto error_mark = begin_branches<DIAG>();\n");
+    for (unsigned idx = 0; idx < branches.size(); ++idx) {
+      if (select_p) {
+        src_out("if ((candidates & 0x{:x}) && branch_call(&{}<DIAG>, one_of_err, {}, name) && ++one_of_count > 1) {{\n",
+                1U << idx, branches[idx], var);
+      } else {
+        src_out("if (branch_call(&{}<DIAG>, one_of_err, {}, name) && ++one_of_count > 1) {{\n", branches[idx], var);
+      }
       indent_src();
-      validate_node(schema, "node");
-      src_out("return true;\n");
+      src_out("if constexpr (DIAG) end_branches(error_mark, false);\n");
+      emit_error("Node '#{0}' at line {1} was valid for more than one schema.", node, {}, var);
       exdent_src();
-      src_out("}},\n");
+      src_out("}}\n");
     }
-    exdent_src();
-    src_out("}};\n");
-    src_out("unsigned one_of_count = 0;\nfor ( auto && vf : one_of_verify "
-            ") {{\n");
-    indent_src();
-    src_out("if (vf({}) && ++one_of_count > 1) {{\n", var);
+    src_out("if constexpr (DIAG) end_branches(error_mark, one_of_count != 1);\n");
+    src_out("if (one_of_count != 1) {{\n");
     indent_src();
-    src_out("erratum.error(\"Node at line {{}} was valid for more than one "
-            "schema.\", {}.Mark().line);\nreturn false;\n",
-            var);
-    exdent_src();
-    src_out("}}\n");
+    src_out("if constexpr (DIAG) erratum.note(one_of_err);\n");
+    emit_error("Node '#{0}' at line {1} was not valid for any of these schemas.", node, {}, var);
     exdent_src();
     src_out("}}\n");
-    src_out("if (one_of_count != 1) {{\n");
-    indent_src();
-    src_out("erratum.note(one_of_err);\nerratum.error(\"'{{}}' value at line {{}} "
-            "was not valid for any of these schemas.\", name,"
-            "{}.Mark().line);\nreturn false;\n",
-            var);
     exdent_src();
     src_out("}}\n");
   }
-  return notes;
+  return zret;
 }
 
-Errata
-Context::process_enum_value(YAML::Node const &node, std::string_view const &var)
+YAML::Node
+Context::resolve(YAML::Node node)
 {
-  if (!node.IsSequence()) {
-    return notes.error("'{}' value at line {} is invalid - it must be {} type.", node.Mark().line,
-                       SchemaTypeLexicon[SchemaType::ARRAY]);
-  } else if (node.size() < 1) {
-    notes.warn("'{}' value at line {} has no items - ignored.", PropName[Property::ENUM], node.Mark().line);
-  } else {
-    std::string usage;
-    static const std::string separator{", "};
-    src_out("bool enum_match_p = false;\nfor ( auto && vn : {{ ");
-    // Because the enum can be any type, the only reliable approach is to serialized the enum values
-    // and reconstitute them in the validator. Need to check if the initializer list reloads every
-    // invocation or not - may need to move these to a static list for that reason.
-    for (auto &&n : node) {
-      YAML::Emitter e;
-      e << n;
-      src_out("YAML::Load(R\"uthira({})uthira\"), ", e.c_str());
-      usage += e.c_str() + separator;
+  // Limit the depth in case of a reference loop.
+  for (int depth = 0; depth < 16 && node.IsMap() && node[REF_KEY]; ++depth) {
+    auto rv{this->locate(root_node, node[REF_KEY].Scalar())};
+    if (!rv.is_ok()) {
+      break;
     }
-    usage.resize(usage.size() - 2);
-    src_out(" }} ) {{\n");
-    indent_src();
-    src_out("if ( equal(vn, {}) ) {{\n", var);
-    indent_src();
-    src_out("enum_match_p = true;\nbreak;\n");
-    exdent_src();
-    src_out("}}\n");
-    exdent_src();
-    src_out("}}\n");
-    src_out("if (!enum_match_p) {{\n");
-    indent_src();
-    src_out(
-      "YAML::Emitter yem;\nyem << {};\nerratum.error(\"'{{}}' value '{{}}' at line {{}} is invalid - it must be one of {{}}.\""
-      ", name, yem.c_str(), {}.Mark().line, R\"uthira({})uthira\");\nreturn false;\n",
-      var, var, usage);
-    exdent_src();
-    src_out("}}\n");
+    node.reset(rv.result());
   }
-  return notes;
+  return node;
 }
 
-Errata
-Context::process_array_value(YAML::Node const &node, std::string_view const &var, TypeSet const &types)
+Context::BranchFilter
+Context::branch_filter(YAML::Node const &schema)
 {
-  Errata zret;
-  int min_items(0), max_items(std::numeric_limits<int>::max());
+  BranchFilter zret;
+  auto node{this->resolve(schema)};
+  if (!node.IsMap()) {
+    return zret;
+  }
 
-  bool single_type_p = types.count() == 1;
-  bool has_tags_p =
-    std::any_of(ArrayPropNames.begin(), ArrayPropNames.end(), [&](std::string_view const &name) -> bool { return node[name]; });
-
-  // If this value can only be a single type, then all the type checking needed has already been done
-  // so don't double up on the same check. Otherwise it may not be an array and the array properties
-  // should not be applied.
-  if (!single_type_p && has_tags_p) {
-    src_out("if ({}({})) {{\n", SchemaTypeCheck[SchemaType::ARRAY], var);
-    indent_src();
+  if (auto n{node[PropName[Property::TYPE]]}; n) {
+    TypeSet types;
+    if (process_type_value(n, types).severity() < Severity::ERROR) {
+      zret.kinds = 0;
+      for (auto &&[value, name] : SchemaTypeLexicon) {
+        if (types[int(value)]) {
+          switch (value) {
+          case SchemaType::NIL:
+            zret.kinds |= 1 << YAML::NodeType::Null;
+            break;
+          case SchemaType::OBJECT:
+            zret.kinds |= 1 << YAML::NodeType::Map;
+            break;
+          case SchemaType::ARRAY:
+            zret.kinds |= 1 << YAML::NodeType::Sequence;
+            break;
+          default:
+            zret.kinds |= 1 << YAML::NodeType::Scalar;
+            break;
+          }
+        }
+      }
+    }
   }
 
-  if (node[PropName[Property::MIN_ITEMS]]) {
-    auto n_1       = node[PropName[Property::MIN_ITEMS]];
-    TextView value = TextView{n_1.Scalar()}.trim_if(&isspace);
-    TextView parsed;
-    min_items = swoc::svtoi(value, &parsed);
-    if (parsed.size() != value.size() || min_items < 0) {
-      return zret.error("{} value '{}' at line {} for type {} at line {} is invalid - it "
-                        "must be a positive integer.",
-                        PropName[Property::MIN_ITEMS], value, n_1.Mark().line, SchemaTypeLexicon[SchemaType::ARRAY],
-                        node.Mark().line);
+  if (auto n{node[PropName[Property::REQUIRED]]}; n && n.IsSequence()) {
+    for (auto &&key : n) {
+      zret.required.push_back(key.Scalar());
     }
-    emit_min_items_check(var, min_items);
   }
 
-  if (node[PropName[Property::MAX_ITEMS]]) {
-    auto n_1       = node[PropName[Property::MAX_ITEMS]];
-    TextView value = TextView{n_1.Scalar()}.trim_if(&isspace);
-    TextView parsed;
-    max_items = swoc::svtoi(value, &parsed);
-    if (parsed.size() != value.size() || max_items < 0) {
-      return zret.error("{} value '{}' at line {} for type {} at line {} is invalid - it "
-                        "must be a positive integer.",
-                        PropName[Property::MAX_ITEMS], value, n_1.Mark().line, SchemaTypeLexicon[SchemaType::ARRAY],
-                        node.Mark().line);
+  if (auto n{node[PropName[Property::PROPERTIES]]}; n && n.IsMap()) {
+    for (auto &&pair : n) {
+      auto const &key = pair.first;
+      auto prop{this->resolve(pair.second)};
+      if (!prop.IsMap() || prop[PropName[Property::IGNORE_CASE]]) {
+        continue;
+      }
+      std::vector<std::string> values;
+      auto load = [&](YAML::Node const &v) -> bool {
+        if (v.IsScalar()) {
+          values.push_back(v.Scalar());
+          return true;
+        }
+        return false;
+      };
+      if (auto c{prop[PropName[Property::CONST]]}; c) {
+        if (load(c)) {
+          zret.values[key.Scalar()] = std::move(values);
+        }
+      } else if (auto e{prop[PropName[Property::ENUM]]}; e && e.IsSequence()) {
+        if (std::all_of(e.begin(), e.end(), load)) {
+          zret.values[key.Scalar()] = std::move(values);
+        }
+      }
     }
-    emit_max_items_check(var, max_items);
+    if (auto n_1{node[PropName[Property::ADDITIONAL_PROPERTIES]]};
+        n_1 && n_1.IsScalar() && n_1.Scalar() == "false" && !node[PropName[Property::PATTERN_PROPERTIES]]) {
+      zret.closed_p = true;
+      for (auto &&pair : n) {
+        zret.keys.push_back(pair.first.Scalar());
+      }
+    }
+  } else if (auto n_1{node[PropName[Property::ADDITIONAL_PROPERTIES]]};
+             n_1 && n_1.IsScalar() && n_1.Scalar() == "false" && !node[PropName[Property::PATTERN_PROPERTIES]]) {
+    zret.closed_p = true;
   }
 
-  if (min_items > max_items) {
-    return zret.error("For '{}' value at line {}, the '{}' value at line {} is larger than the '{}' value at line {}.",
-                      SchemaTypeLexicon[SchemaType::ARRAY], node.Mark().line, PropName[Property::MIN_ITEMS],
-                      node[PropName[Property::MIN_ITEMS]].Mark().line, PropName[Property::MAX_ITEMS],
-                      node[PropName[Property::MAX_ITEMS]].Mark().line);
+  return zret;
+}
+
+bool
+Context::emit_branch_select(YAML::Node const &branches, std::string_view const &var)
+{
+  static constexpr unsigned N_BITS = std::numeric_limits<unsigned>::digits;
+  if (branches.size() > N_BITS) {
+    return false; // Too many to track, check all of them.
   }
+  unsigned all = branches.size() == N_BITS ? ~0U : (1U << branches.size()) - 1;
 
-  // Handle the items in the sequence.
-  if (auto n_1{node[PropName[Property::ITEMS]]}; n_1) {
-    if (n_1.IsMap()) {
-      // The type values are objects, so each is a schema desciptor.
-      auto nvar = var_name();
-      src_out("for ( auto && {} : {} ) {{\n", nvar, var);
-      indent_src();
-      if (zret.note(validate_node(n_1, nvar)).severity() >= Severity::ERROR) {
-        zret.note(zret.severity(), "Failed processing '{}' value for '{}' at line {}.", SchemaTypeLexicon[SchemaType::OBJECT],
-                  PropName[Property::TYPE], node.Mark().line);
-      }
-      exdent_src();
-      src_out("}}\n");
-    } else if (n_1.IsSequence()) {
-      auto nvar  = var_name();
-      auto limit = n_1.size();
-      if (limit >= max_items) {
-        zret.warn("'{}' at line {} has schemas for {} items at line {} but "
-                  "was specified to have at most {} items by line {}. Extra schemas ignored.",
-                  SchemaTypeLexicon[SchemaType::ARRAY], node.Mark().line, limit, n_1.Mark().line, max_items,
-                  node[PropName[Property::MAX_ITEMS]].Mark().line);
-        limit = max_items;
-      }
-      if (limit <= min_items) {
-        for (int idx = 0; idx < limit; ++idx) {
-          if (zret.note(this->validate_node(n_1[idx], nvar)).severity() >= Severity::ERROR) {
-            return zret.note(zret.severity(), "Failed to process item {} in '{}' at line {}.");
-          }
+  src_out("// select candidate branches\nunsigned candidates = 0x{:x};\n", all);
+
+  std::vector<BranchFilter> filters;
+  for (auto &&schema : branches) {
+    filters.push_back(this->branch_filter(schema));
+  }
+
+  // Filter on node type, if that distinguishes any branches.
+  static constexpr std::array<YAML::NodeType::value, 4> KINDS{
+    {YAML::NodeType::Null, YAML::NodeType::Scalar, YAML::NodeType::Sequence, YAML::NodeType::Map}};
+  static constexpr std::array<std::string_view, 4> KIND_NAMES{{"Null", "Scalar", "Sequence", "Map"}};
+  if (std::any_of(filters.begin(), filters.end(), [&](BranchFilter const &f) { return f.kinds != filters[0].kinds; })) {
+    src_out("switch ({}.Type()) {{\n", var);
+    for (unsigned k = 0; k < KINDS.size(); ++k) {
+      unsigned mask = 0;
+      for (unsigned idx = 0; idx < filters.size(); ++idx) {
+        if (filters[idx].kinds & (1 << KINDS[k])) {
+          mask |= 1U << idx;
         }
-      } else {
-        src_out("switch ({}.size()) {{\n", var);
+      }
+      if (mask != all) {
+        src_out("case YAML::NodeType::{}:\n", KIND_NAMES[k]);
         indent_src();
-        for (int idx = 0; idx < n_1.size(); ++idx) {
-          src_out("case {}: {{\n");
-          indent_src();
-          src_out("auto {} = {}[{}];\n", nvar, var, idx);
-          if (zret.note(validate_node(n_1[idx], nvar)).severity() >= Severity::ERROR) {
-            return zret.note(zret.severity(), "Failed to process value {} at line {} for '{}'.", idx, n_1.Mark().line,
-                             PropName[Property::TYPE]);
-          }
-          src_out("}}\n");
-          exdent_src();
-        }
+        src_out("candidates &= 0x{:x};\nbreak;\n", mask);
         exdent_src();
-        src_out("}}\n");
       }
-    } else {
-      return zret.error("Invalid value for '{}' at line {}: must be a {} or {}.", PropName[Property::ITEMS], n_1.Mark().line,
-                        SchemaTypeLexicon[SchemaType::ARRAY], SchemaTypeLexicon[SchemaType::OBJECT]);
     }
-  }
-
-  if (!single_type_p && has_tags_p) {
+    src_out("default:\n");
+    indent_src();
+    src_out("break;\n");
     exdent_src();
     src_out("}}\n");
   }
 
-  if (!zret.empty()) {
-    zret.note(zret.severity(), "Problems procssing '{}' at line {}", PropName[Property::TYPE], node.Mark().line);
+  // Keys that distinguish branches, checked in a single pass over the keys of the node.
+  std::vector<std::string> keys;
+  auto key_idx = [&](std::string const &key) -> size_t {
+    auto spot = std::find(keys.begin(), keys.end(), key);
+    if (spot == keys.end()) {
+      keys.push_back(key);
+      return keys.size() - 1;
+    }
+    return spot - keys.begin();
+  };
+  unsigned closed = 0;
+  for (unsigned idx = 0; idx < filters.size(); ++idx) {
+    auto &f = filters[idx];
+    if (f.kinds & (1 << YAML::NodeType::Map)) {
+      for (auto &&key : f.required) {
+        key_idx(key);
+      }
+      for (auto &&[key, values] : f.values) {
+        key_idx(key);
+      }
+      if (f.closed_p) {
+        closed |= 1U << idx;
+        for (auto &&key : f.keys) {
+          key_idx(key);
+        }
+      }
+    }
+  }
+  if (keys.empty() && closed == 0) {
+    src_out("if (candidates == 0) {{\n  candidates = 0x{:x}; // Nothing can match, check all for diagnostics.\n}}\n", all);
+    return true;
   }
-  return zret;
-}
 
-Errata
-Context::process_object_value(YAML::Node const &node, std::string_view const &var, TypeSet const &types)
-{
-  bool single_type_p = types.count() == 1;
-  bool has_tags_p =
-    std::any_of(ObjectPropNames.begin(), ObjectPropNames.end(), [&](std::string_view const &name) -> bool { return node[name]; });
-  if (!single_type_p && has_tags_p) {
-    src_out("if ({}({})) {{\n", var, SchemaTypeCheck[SchemaType::OBJECT]);
+  auto pvar = var_name();
+  src_out("if (candidates && {}.IsMap()) {{\n", var);
+  indent_src();
+  src_out("std::bitset<{}> present;\n", keys.size());
+  src_out("for ( auto && {} : {} ) {{\n", pvar, var);
+  indent_src();
+  src_out("int key_idx = -1;\n");
+  if (!keys.empty()) {
+    src_out("if ({}.first.IsScalar()) {{\n", pvar);
     indent_src();
+    src_out("std::string_view key{{{}.first.Scalar()}};\n", pvar);
+    emit_string_dispatch(keys, "key", false, [&](size_t idx) { src_out("key_idx = {};\n", idx); });
+    exdent_src();
+    src_out("}}\n");
   }
-  if (node[PropName[Property::REQUIRED]]) {
-    auto required_node = node[PropName[Property::REQUIRED]];
-    if (!required_node.IsSequence()) {
-      return notes.error("'{}' value at line {} is not type {}.", PropName[Property::REQUIRED], required_node.Mark().line,
-                         SchemaTypeLexicon[SchemaType::ARRAY]);
+  src_out("switch (key_idx) {{\n");
+  for (size_t k = 0; k < keys.size(); ++k) {
+    auto const &key = keys[k];
+    src_out("case {}: {{\n", k);
+    indent_src();
+    src_out("present[{}] = true;\n", k);
+    // Closed branches that do not have this key.
+    unsigned excluded = 0;
+    for (unsigned idx = 0; idx < filters.size(); ++idx) {
+      auto &f = filters[idx];
+      if (f.closed_p && f.keys.end() == std::find(f.keys.begin(), f.keys.end(), key)) {
+        excluded |= 1U << idx;
+      }
     }
-    emit_required_check(required_node, var);
-  }
-  if (node[PropName[Property::PROPERTIES]]) {
-    auto n_1 = node[PropName[Property::PROPERTIES]];
-    if (!n_1.IsMap()) {
-      return notes.error("'{}' value at line {} is not type {}.", PropName[Property::PROPERTIES], n_1.Mark().line,
-                         SchemaTypeLexicon[SchemaType::OBJECT]);
+    if (excluded) {
+      src_out("candidates &= ~0x{:x}U;\n", excluded);
     }
-    auto nvar = this->var_name();
-    for (auto &&pair : n_1) {
-      src_out("if ({}[\"{}\"]) {{\n", var, pair.first.Scalar());
+    // Branches that restrict the value for this key.
+    std::vector<std::string> values;
+    std::vector<unsigned> masks;
+    unsigned accept = all;
+    for (unsigned idx = 0; idx < filters.size(); ++idx) {
+      if (auto spot = filters[idx].values.find(key); spot != filters[idx].values.end()) {
+        accept &= ~(1U << idx);
+        for (auto &&v : spot->second) {
+          auto vspot = std::find(values.begin(), values.end(), v);
+          if (vspot == values.end()) {
+            values.push_back(v);
+            masks.push_back(0);
+            vspot = values.end() - 1;
+          }
+          masks[vspot - values.begin()] |= 1U << idx;
+        }
+      }
+    }
+    if (!values.empty()) {
+      src_out("unsigned accept = 0x{:x};\n", accept);
+      src_out("if ({}.second.IsScalar()) {{\n", pvar);
       indent_src();
-      src_out("auto {} = {}[\"{}\"];\n", nvar, var, pair.first.Scalar());
-      this->validate_node(pair.second, nvar);
+      src_out("std::string_view value{{{}.second.Scalar()}};\n", pvar);
+      emit_string_dispatch(values, "value", false, [&](size_t idx) { src_out("accept |= 0x{:x};\n", masks[idx]); });
       exdent_src();
       src_out("}}\n");
+      src_out("candidates &= accept;\n");
     }
-  }
-  if (!single_type_p && has_tags_p) {
+    src_out("break;\n");
     exdent_src();
     src_out("}}\n");
   }
-  return notes;
+  if (closed) {
+    src_out("default:\n");
+    indent_src();
+    src_out("candidates &= ~0x{:x}U;\nbreak;\n", closed);
+    exdent_src();
+  }
+  src_out("}}\n");
+  exdent_src();
+  src_out("}}\n");
+
+  // Branches with required keys that are not present.
+  for (unsigned idx = 0; idx < filters.size(); ++idx) {
+    auto &f = filters[idx];
+    if ((f.kinds & (1 << YAML::NodeType::Map)) && !f.required.empty()) {
+      std::vector<size_t> bits;
+      for (auto &&key : f.required) {
+        bits.push_back(key_idx(key));
+      }
+      std::string name;
+      swoc::bwprint(name, "required_{}", idx);
+      emit_bitset_const(name, keys.size(), bits);
+      src_out("if ((present & {}) != {}) {{\n  candidates &= ~0x{:x}U;\n}}\n", name, name, 1U << idx);
+    }
+  }
+  exdent_src();
+  src_out("}}\n");
+  src_out("if (candidates == 0) {{\n  candidates = 0x{:x}; // Nothing can match, check all for diagnostics.\n}}\n", all);
+  return true;
 }
 
 Errata
-Context::validate_node(YAML::Node const &value, std::string_view const &var)
+Context::process_branch(YAML::Node const &node, std::string_view const &tag, std::string &fn)
 {
   Errata zret;
-  if (!value.IsMap()) {
-    return zret.error("Value at line {} must be a {}.", value.Mark().line, SchemaTypeLexicon[SchemaType::OBJECT]);
-  }
-
-  if (auto n{value["$ref"]}; n) {
-    if (value.size() > 1) {
-      zret.warn("Ignoring tags in value at line {} - use of '$ref' tag at "
-                "line {} requires ignoring all other tags.",
-                value.Mark().line, n.Mark().line);
-    }
-    if (auto spot = definitions.find(n.Scalar()); spot != definitions.end()) {
-      src_out("if (! defun.{}(erratum, {}, name)) return false;\n", spot->second, var);
-    } else {
-      zret.error("Invalid '$ref' at line {} in value at line {} - '{}' not found.", n.Mark().line, value.Mark().line, n.Scalar());
+  // A branch that is only a reference can use the definition directly.
+  if (node.IsMap() && node[REF_KEY] && validation_tag_count(node) == 1) {
+    if (auto spot = definitions.find(node[REF_KEY].Scalar()); spot != definitions.end()) {
+      fn = spot->second;
+      return zret;
     }
-    return zret;
   }
+  fn = this->fn_name(tag);
+  this->begin_validator(fn);
+  zret.note(this->validate_node(node, "node"));
+  this->end_validator();
+  return zret;
+}
 
-  TypeSet types;
-  if (auto n{value[PropName[Property::TYPE]]}; n) {
-    if (zret.note(process_type_value(n, types)).severity() >= Severity::ERROR) {
-      return zret.note(zret.severity(), "Unable to process value at line {} for '{}' at line {}", n.Mark().line,
-                       PropName[Property::TYPE], value.Mark().line);
-    }
-    emit_type_check(types, var);
-  } else {
-    types.set();
+Errata
+Context::merge_all_of(YAML::Node const &node, YAML::Node &merged, std::vector<YAML::Node> &rest)
+{
+  Errata zret;
+  auto all_of_n{node[PropName[Property::ALL_OF]]};
+  if (!all_of_n.IsSequence()) {
+    return zret.error("'{}' value at line {} is invalid - it must be {} type.", PropName[Property::ALL_OF], all_of_n.Mark().line,
+                      SchemaTypeLexicon[SchemaType::ARRAY]);
   }
 
-  if (types[int(SchemaType::OBJECT)]) { // could be an object.
-    if (zret.note(process_object_value(value, var, types)).severity() >= Severity::ERROR) {
-      return zret.note(zret.severity(), "Unable to process value at line {} as {}", value.Mark().line,
-                       SchemaTypeLexicon[SchemaType::OBJECT]);
-    }
-  }
+  // Counts where the merged value is the maximum or minimum of the branch values.
+  static const std::array<Property, 3> MinCounts{{Property::MIN_PROPERTIES, Property::MIN_ITEMS, Property::MIN_LENGTH}};
+  static const std::array<Property, 3> MaxCounts{{Property::MAX_PROPERTIES, Property::MAX_ITEMS, Property::MAX_LENGTH}};
+  auto is_count = [](auto const &props, std::string const &key) {
+    return std::any_of(props.begin(), props.end(), [&](Property p) { return PropName[p] == key; });
+  };
+  auto count_of = [](YAML::Node const &n) -> intmax_t {
+    TextView text{n.IsScalar() ? TextView{n.Scalar()} : TextView{}};
+    TextView parsed;
+    auto count = swoc::svtoi(text, &parsed);
+    return parsed.empty() || parsed.size() != text.size() ? -1 : count;
+  };
+  // Keys that determine which object keys are additional.
+  auto is_shape = [](std::string const &key) {
+    return key == PropName[Property::PROPERTIES] || key == PropName[Property::PATTERN_PROPERTIES] ||
+           key == PropName[Property::ADDITIONAL_PROPERTIES];
+  };
+  // Keys whose meaning depends on sibling keys, with those siblings. Moving either between schemas
+  // changes the meaning, e.g. additionalItems without items has no effect.
+  static const std::array<std::pair<Property, std::array<Property, 2>>, 6> Dependents{{
+    {Property::ADDITIONAL_ITEMS, {{Property::ITEMS, Property::PREFIX_ITEMS}}},
+    {Property::THEN, {{Property::IF, Property::IF}}},
+    {Property::ELSE, {{Property::IF, Property::IF}}},
+    {Property::IGNORE_CASE, {{Property::ENUM, Property::CONST}}},
+    {Property::EXCLUSIVE_MINIMUM, {{Property::MINIMUM, Property::MINIMUM}}},
+    {Property::EXCLUSIVE_MAXIMUM, {{Property::MAXIMUM, Property::MAXIMUM}}},
+  }};
+  auto is_dependent = [](Property prop, YAML::Node const &n) {
+    // Only the draft 4 boolean form of the exclusive limits depends on the limit.
+    return n && ((prop != Property::EXCLUSIVE_MINIMUM && prop != Property::EXCLUSIVE_MAXIMUM) ||
+                 (n.IsScalar() && (n.Scalar() == "true" || n.Scalar() == "false")));
+  };
+  // Whether @a schema has a dependent key, or a sibling key of a dependent key in @a other.
+  auto has_dependent = [&](YAML::Node const &schema, YAML::Node const &other) {
+    return std::any_of(Dependents.begin(), Dependents.end(), [&](auto const &dep) {
+      auto const &[prop, siblings] = dep;
+      return is_dependent(prop, schema[PropName[prop]]) ||
+             (is_dependent(prop, other[PropName[prop]]) &&
+              (schema[PropName[siblings[0]]] || schema[PropName[siblings[1]]]));
+    });
+  };
 
-  if (types[int(SchemaType::ARRAY)]) { // could be an array
-    if (zret.note(process_array_value(value, var, types)).severity() >= Severity::ERROR) {
-      return zret.note(zret.severity(), "Unable to process value at line {}", value.Mark().line);
+  merged = YAML::Node(YAML::NodeType::Map);
+  YAML::Node const &lookup = merged; // Look up keys without adding them.
+  for (auto &&pair : node) {
+    if (pair.first.Scalar() != PropName[Property::ALL_OF]) {
+      merged[pair.first.Scalar()] = pair.second;
     }
   }
 
-  if (auto n{value[PropName[Property::ANY_OF]]}; n) {
-    if (zret.note(process_any_of_value(n, var)).severity() >= Severity::ERROR) {
-      return zret;
-    }
+  std::deque<YAML::Node> branches;
+  for (auto &&b : all_of_n) {
+    branches.emplace_back(b);
   }
-
-  if (auto n{value[PropName[Property::ONE_OF]]}; n) {
-    if (zret.note(process_one_of_value(n, var)).severity() >= Severity::ERROR) {
-      return zret;
+  // Schemas already merged - a schema that refers back to one of these adds nothing more.
+  std::vector<YAML::Node> done{node};
+  while (!branches.empty()) {
+    auto branch = branches.front();
+    branches.pop_front();
+    auto schema{this->resolve(branch)};
+    if (std::any_of(done.begin(), done.end(), [&](YAML::Node const &n) { return n.is(schema); })) {
+      continue;
     }
-  }
-
-  if (auto n{value[PropName[Property::ENUM]]}; n) {
-    if (zret.note(process_enum_value(n, var)).severity() >= Severity::ERROR) {
-      return zret;
+    if (!schema.IsMap() || schema[REF_KEY] || has_dependent(schema, lookup)) {
+      rest.push_back(branch);
+      continue;
     }
-  }
-
-  return zret;
-}
 
-Rv<YAML::Node> Context::locate(YAML::Node node, TextView path) {
-  Rv<YAML::Node> zret;
-  TextView location { path }; // save original path.
-  while (location) {
-    auto elt { location.take_prefix_at('/') };
-    if (elt.empty() || elt == "#") {
-      node.reset(root_node);
+    // Check if every tag in the branch can be merged.
+    bool closed_p = lookup[PropName[Property::ADDITIONAL_PROPERTIES]] || schema[PropName[Property::ADDITIONAL_PROPERTIES]];
+    bool mergeable_p = true;
+    for (auto &&pair : schema) {
+      auto const &key = pair.first.Scalar();
+      if (key == PropName[Property::ALL_OF] ||
+          AnnotationNames.end() != std::find(AnnotationNames.begin(), AnnotationNames.end(), key)) {
+        continue;
+      }
+      if (closed_p && is_shape(key) && std::any_of(merged.begin(), merged.end(), [&](auto const &p) { return is_shape(p.first.Scalar()); })) {
+        mergeable_p = false;
+      } else if (lookup[key]) {
+        if (key == PropName[Property::TYPE] || key == PropName[Property::REQUIRED] || key == PropName[Property::PROPERTIES]) {
+          continue;
+        } else if (is_count(MinCounts, key) || is_count(MaxCounts, key)) {
+          mergeable_p = count_of(lookup[key]) >= 0 && count_of(pair.second) >= 0;
+        } else {
+          mergeable_p = false;
+        }
+      }
+      if (!mergeable_p) {
+        break;
+      }
+    }
+    if (!mergeable_p) {
+      rest.push_back(branch);
       continue;
     }
-    if (node.IsMap()) {
-      if (node[elt]) {
-        node.reset(node[elt]);
-      } else {
-        zret.errata().error(R"("{}" is not in the map {} at {}.)", elt, path.prefix(path.size() - location.size()), node.Mark());
-        break;
+    done.push_back(schema);
+
+    // Nested allOf branches are merged as well.
+    if (auto n{schema[PropName[Property::ALL_OF]]}; n && n.IsSequence()) {
+      for (auto &&b : n) {
+        branches.emplace_back(b);
       }
-    } else {
-      zret.errata().error(R"("{}" is not a map.)", path.prefix(path.size() - location.size()));
-      break;
     }
-  };
-  if (zret.is_ok()) {
-    zret = node;
-  }
-  return std::move(zret);
-}
 
-Errata
-Context::process_definitions(YAML::Node const& node) {
-  Errata erratum;
-  if (node.IsMap()) {
-    if (auto ref_node{node[REF_KEY]} ; ref_node) {
-      if (auto spot = definitions.find(ref_node.Scalar()) ; spot == definitions.end()) {
-        auto def_rv { this->locate(node, ref_node.Scalar()) };
-        if (def_rv.is_ok()) {
-          TextView name { ref_node.Scalar() };
-          if (name.starts_with("#/")) {
-            name.remove_prefix(2);
+    for (auto &&pair : schema) {
+      auto const &key = pair.first.Scalar();
+      YAML::Node const value{pair.second};
+      if (key == PropName[Property::ALL_OF] ||
+          AnnotationNames.end() != std::find(AnnotationNames.begin(), AnnotationNames.end(), key)) {
+        continue;
+      }
+      YAML::Node const current{lookup[key]};
+      if (!current) {
+        merged[key] = value;
+      } else if (key == PropName[Property::TYPE]) {
+        TypeSet lhs, rhs;
+        if (zret.note(process_type_value(current, lhs)).severity() >= Severity::ERROR ||
+            zret.note(process_type_value(value, rhs)).severity() >= Severity::ERROR) {
+          return zret;
+        }
+        auto types = lhs & rhs;
+        // An integer is also a number.
+        if ((lhs[int(SchemaType::NUMBER)] && rhs[int(SchemaType::INTEGER)]) ||
+            (rhs[int(SchemaType::NUMBER)] && lhs[int(SchemaType::INTEGER)])) {
+          types[int(SchemaType::INTEGER)] = true;
+        }
+        if (types.none()) {
+          return zret.error("'{}' at line {} has branches with no '{}' in common.", PropName[Property::ALL_OF],
+                            all_of_n.Mark().line, PropName[Property::TYPE]);
+        }
+        YAML::Node type_n{YAML::NodeType::Sequence};
+        for (auto &&[type, name] : SchemaTypeLexicon) {
+          if (types[int(type)]) {
+            type_n.push_back(std::string{name});
           }
-          std::string defun;
-          swoc::bwprint(defun, "v_{}", name);
-          std::transform(defun.begin(), defun.end(), defun.begin(), [](char c) { return isalnum(c) ? c : '_'; });
-          definitions[ref_node.Scalar()] = defun;
-          // Generate any dependent definitions.
-          erratum.note(this->process_definitions(def_rv));
-          if (erratum.is_ok()) {
-            // Generate this definition.
-            hdr_out(
-                "bool {} (swoc::Errata &erratum, YAML::Node const& node, std::string_view const& name);\n"
-                , defun);
-
-            src_out(
-                "bool {}::Definitions::{} (swoc::Errata &erratum, YAML::Node const& node, std::string_view const& name) {{\n"
-                , class_name, defun);
-            indent_src();
-            erratum.note(validate_node(def_rv, "node"));
-            src_out("return true;\n");
-            exdent_src();
-            src_out("}}\n\n");
+        }
+        merged[key] = type_n;
+      } else if (key == PropName[Property::REQUIRED]) {
+        YAML::Node required_n{YAML::NodeType::Sequence};
+        for (auto const &n : {current, value}) {
+          for (auto &&k : n) {
+            if (std::none_of(required_n.begin(), required_n.end(), [&](auto const &r) { return r.Scalar() == k.Scalar(); })) {
+              required_n.push_back(static_cast<YAML::Node const &>(k));
+            }
           }
-
-          if (!erratum.is_ok()) {
-            erratum.info(R"(Failed to generate definition "{}" at {}, used at {})", ref_node.Scalar(), def_rv.result(), ref_node.Mark());
+        }
+        merged[key] = required_n;
+      } else if (key == PropName[Property::PROPERTIES]) {
+        // Schemas for the same key in both are combined with another allOf. Note the nodes are
+        // shared with the schema, so new nodes must be built rather than updating existing ones.
+        YAML::Node props_n{YAML::NodeType::Map};
+        for (auto &&p : current) {
+          auto prop{value[p.first.Scalar()]};
+          if (prop) {
+            YAML::Node list{YAML::NodeType::Sequence};
+            list.push_back(static_cast<YAML::Node const &>(p.second));
+            list.push_back(prop);
+            YAML::Node combined{YAML::NodeType::Map};
+            combined[PropName[Property::ALL_OF]] = list;
+            props_n[p.first.Scalar()]            = combined;
+          } else {
+            props_n[p.first.Scalar()] = p.second;
           }
-        } else {
-          erratum.note(def_rv);
-          erratum.error(R"(Unable to find ref "{}" used at {}.)", ref_node.Scalar(), ref_node.Mark());
         }
-      } // else it's already been processed.
-    } else {
-      for ( [[maybe_unused]] auto const& [ key, value ] : node ) {
-        erratum.note(this->process_definitions(value));
+        for (auto &&p : value) {
+          if (!current[p.first.Scalar()]) {
+            props_n[p.first.Scalar()] = p.second;
+          }
+        }
+        merged[key] = props_n;
+      } else if (is_count(MinCounts, key)) {
+        merged[key] = YAML::Node(std::max(count_of(current), count_of(value)));
+      } else if (is_count(MaxCounts, key)) {
+        merged[key] = YAML::Node(std::min(count_of(current), count_of(value)));
       }
     }
-  } else if (node.IsSequence()) {
-    for ( auto const& n : node ) {
-      erratum.note(this->process_definitions(n));
-    }
   }
-  return erratum;
+  return zret;
 }
 
-
 Errata
-process(int argc, char *argv[])
+Context::process_not_value(YAML::Node const &node, std::string_view const &var)
 {
-  int zret;
-  int idx;
-  Context ctx;
-  std::string tmp;
+  Errata zret;
+  std::string fn;
+  if (zret.note(this->process_branch(node, "not", fn)).severity() >= Severity::ERROR) {
+    return zret.note(zret.severity(), "Processing '{}' value at line '{}'", PropName[Property::NOT], node.Mark().line);
+  }
+  src_out("// {}\n{{\n", PropName[Property::NOT]);
+  indent_src();
+  src_out("swoc::Errata not_err;\nif (condition_call(&{}<false>, not_err, {}, name)) {{\n", fn, var);
+  indent_src();
+  emit_error("'#{0}' value at line {1} must not be valid for the schema at line {6}.", node, {}, var);
+  exdent_src();
+  src_out("}}\n");
+  exdent_src();
+  src_out("}}\n");
+  return zret;
+}
+
+Errata
+Context::process_if_value(YAML::Node const &node, std::string_view const &var)
+{
+  Errata zret;
+  auto then_n{node[PropName[Property::THEN]]};
+  auto else_n{node[PropName[Property::ELSE]]};
+  if (!then_n && !else_n) {
+    return zret.info("'{}' at line {} has neither '{}' nor '{}' - ignored.", PropName[Property::IF], node.Mark().line,
+                     PropName[Property::THEN], PropName[Property::ELSE]);
+  }
+
+  std::string if_fn, then_fn, else_fn;
+  if (zret.note(this->process_branch(node[PropName[Property::IF]], "if", if_fn)).severity() >= Severity::ERROR ||
+      (then_n && zret.note(this->process_branch(then_n, "then", then_fn)).severity() >= Severity::ERROR) ||
+      (else_n && zret.note(this->process_branch(else_n, "else", else_fn)).severity() >= Severity::ERROR)) {
+    return zret.note(zret.severity(), "Processing '{}' value at line '{}'", PropName[Property::IF], node.Mark().line);
+  }
+
+  // The condition is only a selector, so only the fast variant is used.
+  src_out("// {}\n{{\n", PropName[Property::IF]);
+  indent_src();
+  src_out("swoc::Errata if_err;\n");
+  if (then_n) {
+    src_out("if (condition_call(&{}<false>, if_err, {}, name)) {{\n", if_fn, var);
+    indent_src();
+    emit_validator_call(then_fn, var);
+    exdent_src();
+    if (else_n) {
+      src_out("}} else {{\n");
+      indent_src();
+      emit_validator_call(else_fn, var);
+      exdent_src();
+    }
+    src_out("}}\n");
+  } else {
+    src_out("if (! condition_call(&{}<false>, if_err, {}, name)) {{\n", if_fn, var);
+    indent_src();
+    emit_validator_call(else_fn, var);
+    exdent_src();
+    src_out("}}\n");
+  }
+  exdent_src();
+  src_out("}}\n");
+  return zret;
+}
+
+Errata
+Context::process_enum_value(YAML::Node const &node, std::string_view const &var, bool nocase_p)
+{
+  Errata zret;
+  if (!node.IsSequence()) {
+    return zret.error("'{}' value at line {} is invalid - it must be {} type.", PropName[Property::ENUM], node.Mark().line,
+                      SchemaTypeLexicon[SchemaType::ARRAY]);
+  } else if (node.size() < 1) {
+    zret.warn("'{}' value at line {} has no items - ignored.", PropName[Property::ENUM], node.Mark().line);
+    return zret;
+  }
+  return this->emit_value_check(node, {node.begin(), node.end()}, var, nocase_p, Property::ENUM);
+}
+
+Errata
+Context::process_const_value(YAML::Node const &node, std::string_view const &var, bool nocase_p)
+{
+  return this->emit_value_check(node, {node}, var, nocase_p, Property::CONST);
+}
+
+Errata
+Context::process_string_value(YAML::Node const &node, std::string_view const &var, TypeSet const &types)
+{
+  Errata zret;
+  int min_length = 0;
+  int max_length = std::numeric_limits<int>::max();
+  if (zret.note(load_count(node, Property::MIN_LENGTH, min_length)).severity() >= Severity::ERROR ||
+      zret.note(load_count(node, Property::MAX_LENGTH, max_length)).severity() >= Severity::ERROR) {
+    return zret;
+  }
+  if (min_length > max_length) {
+    return zret.error("For '{}' value at line {}, the '{}' value is larger than the '{}' value.", SchemaTypeLexicon[SchemaType::STRING],
+                      node.Mark().line, PropName[Property::MIN_LENGTH], PropName[Property::MAX_LENGTH]);
+  }
+
+  // Lengths apply only to strings, which are all scalars.
+  bool single_type_p = types.count() == 1;
+  if (!single_type_p) {
+    src_out("if ({}.IsScalar()) {{\n", var);
+    indent_src();
+  }
+  std::string length;
+  swoc::bwprint(length, "{}_length", var);
+  src_out("auto {} = utf8_length({}.Scalar());\n", length, var);
+  src_out("if ({} < 0) {{\n", length);
+  indent_src();
+  emit_error("'#{0}' value at line {1} is not valid UTF-8.", node, {}, var);
+  exdent_src();
+  src_out("}}\n");
+  if (node[PropName[Property::MIN_LENGTH]]) {
+    src_out("if ({} < {}) {{\n", length, min_length);
+    indent_src();
+    emit_error("'#{0}' value at line {1} has only {4} characters instead of the required {5}.", node, {}, var, length,
+               std::to_string(min_length));
+    exdent_src();
+    src_out("}}\n");
+  }
+  if (node[PropName[Property::MAX_LENGTH]]) {
+    src_out("if ({} > {}) {{\n", length, max_length);
+    indent_src();
+    emit_error("'#{0}' value at line {1} has {4} characters instead of the maximum {5}.", node, {}, var, length,
+               std::to_string(max_length));
+    exdent_src();
+    src_out("}}\n");
+  }
+  if (!single_type_p) {
+    exdent_src();
+    src_out("}}\n");
+  }
+  return zret;
+}
+
+Errata
+Context::process_pattern_value(YAML::Node const &node, std::string_view const &var)
+{
+  Errata zret;
+  if (!node.IsScalar()) {
+    return zret.error("'{}' value at line {} must be a string.", PropName[Property::PATTERN], node.Mark().line);
+  }
+  auto const &pattern = node.Scalar();
+  std::string matcher;
+  if (zret.note(this->matcher({pattern}, matcher)).severity() >= Severity::ERROR) {
+    return zret.error("Unable to compile '{}' value at line {}.", PropName[Property::PATTERN], node.Mark().line);
+  }
+  // Patterns apply only to strings.
+  src_out("if ({}.IsScalar() && ! {}({}.Scalar())) {{\n", var, matcher, var);
+  indent_src();
+  emit_error("'#{0}' value '{3}' at line {1} does not match the pattern {2}.", node, pattern, var);
+  exdent_src();
+  src_out("}}\n");
+  return zret;
+}
+
+Errata
+Context::process_format_value(YAML::Node const &node, std::string_view const &var)
+{
+  Errata zret;
+  if (!node.IsScalar()) {
+    return zret.error("'{}' value at line {} must be a string.", PropName[Property::FORMAT], node.Mark().line);
+  }
+  auto format = FormatName[node.Scalar()];
+  if (format == Format::INVALID) {
+    // Formats are annotations unless supported.
+    return zret.info("Unsupported '{}' value '{}' at line {} ignored.", PropName[Property::FORMAT], node.Scalar(), node.Mark().line);
+  }
+  switch (format) {
+  case Format::IPV4:
+  case Format::IPV6:
+  case Format::IP_ADDRESS:
+  case Format::IP_RANGE:
+  case Format::CIDR:
+    ip_format_p = true;
+    break;
+  default:
+    text_format_p = true;
+    break;
+  }
+  // Formats apply only to strings, except that an IP range can also be a pair of addresses.
+  if (format == Format::IP_RANGE) {
+    src_out("if (({0}.IsScalar() || {0}.IsSequence()) && ! {1}({0})) {{\n", var, FormatCheck[format]);
+  } else {
+    src_out("if ({}.IsScalar() && ! {}({})) {{\n", var, FormatCheck[format], var);
+  }
+  indent_src();
+  emit_error("'#{0}' value '{3}' at line {1} is not a valid {2}.", node, node.Scalar(), var);
+  exdent_src();
+  src_out("}}\n");
+  return zret;
+}
+
+Errata
+Context::process_check_value(YAML::Node const &node, std::string_view const &var)
+{
+  Errata zret;
+  // Function names must be (possibly qualified) identifiers as they are pasted in to the generated code.
+  auto valid = [](YAML::Node const &n) -> bool {
+    if (!n.IsScalar()) {
+      return false;
+    }
+    std::string_view name{n.Scalar()};
+    for (size_t start = 0;;) {
+      auto end = name.find("::", start);
+      auto id  = name.substr(start, end - start);
+      if (id.empty() || isdigit(id[0]) || !std::all_of(id.begin(), id.end(), [](char c) { return isalnum(c) || c == '_'; })) {
+        return false;
+      }
+      if (end == std::string_view::npos) {
+        return true;
+      }
+      start = end + 2;
+    }
+  };
+  std::vector<YAML::Node> checks;
+  if (node.IsSequence()) {
+    for (auto &&n : node) {
+      checks.push_back(n);
+    }
+  } else {
+    checks.push_back(node);
+  }
+  for (auto const &n : checks) {
+    if (!valid(n)) {
+      return zret.error("'{}' value at line {} must be a function name or an array of function names.", PropName[Property::CHECK],
+                        n.Mark().line);
+    }
+  }
+  if (includes.empty() && !check_p) {
+    zret.warn("'{}' at line {} is used but no header was specified with '--include'.", PropName[Property::CHECK], node.Mark().line);
+  }
+  check_p = true;
+  for (auto const &n : checks) {
+    src_out("if (! {}(erratum, {}, name)) return false;\n", n.Scalar(), var);
+  }
+  return zret;
+}
+
+Errata
+Context::matcher(std::vector<std::string> const &patterns, std::string &name)
+{
+  Errata zret;
+  std::string key;
+  for (auto const &pattern : patterns) {
+    key.append(pattern).push_back('\0');
+  }
+  auto spot = matchers.find(key);
+  if (spot == matchers.end()) {
+    Dfa dfa;
+    if (zret.note(dfa.compile(patterns)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+    spot = matchers.emplace(key, this->emit_matcher(dfa, patterns)).first;
+  }
+  name = spot->second;
+  return zret;
+}
+
+std::string
+Context::emit_matcher(Dfa const &dfa, std::vector<std::string> const &patterns)
+{
+  std::string name;
+  std::string tmp;
+  swoc::bwprint(name, "match_pattern_{}", var_idx++);
+
+  std::string_view state_type = dfa.size() <= 256 ? "uint8_t" : "uint16_t";
+  std::ostringstream out;
+  for (auto const &pattern : patterns) {
+    std::string text{pattern};
+    std::replace(text.begin(), text.end(), '\n', ' ');
+    out << "// " << text << '\n';
+  }
+  out << swoc::bwprint(tmp, "uint64_t\n{}(std::string_view text)\n{{\n", name);
+  out << "  static constexpr uint8_t classes[256] = {";
+  for (unsigned c = 0; c < 256; ++c) {
+    out << (c % 32 ? " " : "\n    ") << unsigned(dfa._classes[c]) << ',';
+  }
+  out << swoc::bwprint(tmp, "\n  }};\n  static constexpr {} delta[{}][{}] = {{", state_type, dfa.size(), dfa._n_classes);
+  for (unsigned state = 0; state < dfa.size(); ++state) {
+    out << "\n    {";
+    for (unsigned k = 0; k < dfa._n_classes; ++k) {
+      out << (k ? ", " : "") << dfa._delta[state * dfa._n_classes + k];
+    }
+    out << "},";
+  }
+  out << swoc::bwprint(tmp, "\n  }};\n  static constexpr uint64_t accept[{}] = {{", dfa.size());
+  for (unsigned state = 0; state < dfa.size(); ++state) {
+    out << (state ? ", " : "") << swoc::bwprint(tmp, "0x{:x}", dfa._accept[state]);
+  }
+  out << "};\n";
+  out << swoc::bwprint(tmp, "  unsigned state = {};\n  for (unsigned char c : text) {{\n    state = delta[state][classes[c]];\n",
+                       dfa._start);
+  // States past the sink index never change, so the rest of the text can be skipped.
+  if (dfa._sink < dfa.size()) {
+    out << swoc::bwprint(tmp, "    if (state >= {}) {{\n      break;\n    }}\n", dfa._sink);
+  }
+  out << "  }\n  return accept[state];\n}\n\n";
+
+  _src_defs << out.str();
+  return name;
+}
+
+Errata
+Context::emit_value_check(YAML::Node const &schema, std::vector<YAML::Node> const &values, std::string_view const &var, bool nocase_p,
+                          Property prop)
+{
+  Errata zret;
+  // Classify the values - scalars are checked with a generated dispatch table, other values are
+  // checked by structural hash and compared only if the hash matches.
+  std::vector<std::string> scalars;
+  std::map<uint64_t, std::vector<YAML::Node>> others;
+  bool null_p = false;
+  std::string usage;
+  static const std::string separator{", "};
+  for (auto &&n : values) {
+    YAML::Emitter e;
+    e << n;
+    usage += e.c_str() + separator;
+    if (n.IsScalar()) {
+      auto const &text = n.Scalar();
+      if (std::any_of(scalars.begin(), scalars.end(), [&](std::string const &s) {
+            return s.size() == text.size() && (nocase_p ? 0 == strncasecmp(s.data(), text.data(), s.size()) : s == text);
+          })) {
+        zret.warn("'{}' value '{}' at line {} is a duplicate - ignored.", PropName[prop], text, n.Mark().line);
+      } else {
+        scalars.push_back(text);
+      }
+    } else if (n.IsNull()) {
+      null_p = true;
+    } else {
+      others[node_hash(n)].push_back(n);
+    }
+  }
+  usage.resize(usage.size() - separator.size());
+
+  src_out("// {}\n{{\n", PropName[prop]);
+  indent_src();
+  src_out("bool enum_match_p = false;\n");
+  TextView delimiter;
+  if (!scalars.empty()) {
+    src_out("if ({}.IsScalar()) {{\n", var);
+    indent_src();
+    src_out("std::string_view enum_value{{{}.Scalar()}};\n", var);
+    emit_string_dispatch(scalars, "enum_value", nocase_p, [&](size_t) { src_out("enum_match_p = true;\n"); });
+    exdent_src();
+    src_out("}}");
+    delimiter.assign(" else ");
+  }
+  if (null_p) {
+    src_out("{}if ({}.IsNull()) {{\n", delimiter, var);
+    indent_src();
+    src_out("enum_match_p = true;\n");
+    exdent_src();
+    src_out("}}");
+    delimiter.assign(" else ");
+  }
+  if (!others.empty()) {
+    src_out("{}{{\n", delimiter);
+    indent_src();
+    src_out("switch (node_hash({})) {{\n", var);
+    for (auto &&[hash, nodes] : others) {
+      src_out("case {}ULL: {{\n", hash);
+      indent_src();
+      // The comparison value is loaded only on a hash match, and then only once.
+      src_out("static const std::array<YAML::Node, {}> enum_values{{{{\n", nodes.size());
+      indent_src();
+      for (auto &&n : nodes) {
+        YAML::Emitter e;
+        e << n;
+        src_out("YAML::Load(R\"uthira({})uthira\"),\n", e.c_str());
+      }
+      exdent_src();
+      src_out("}}}};\n");
+      src_out("enum_match_p = std::any_of(enum_values.begin(), enum_values.end(), [&](YAML::Node const &vn) {{ return "
+              "equal(vn, {}); }});\n",
+              var);
+      src_out("break;\n");
+      exdent_src();
+      src_out("}}\n");
+    }
+    src_out("}}\n");
+    exdent_src();
+    src_out("}}");
+  }
+  src_out("\n");
+
+  src_out("if (!enum_match_p) {{\n");
+  indent_src();
+  if (prop == Property::CONST) {
+    emit_error("'#{0}' value '{3}' at line {1} is invalid - it must be {2}.", schema, usage, var);
+  } else {
+    emit_error("'#{0}' value '{3}' at line {1} is invalid - it must be one of {2}.", schema, usage, var);
+  }
+  exdent_src();
+  src_out("}}\n");
+  exdent_src();
+  src_out("}}\n");
+  return zret;
+}
+
+Errata
+Context::load_count(YAML::Node const &node, Property prop, int &count)
+{
+  Errata zret;
+  if (auto n_1{node[PropName[prop]]}; n_1) {
+    TextView value = TextView{n_1.Scalar()}.trim_if(&isspace);
+    TextView parsed;
+    auto n = swoc::svtoi(value, &parsed);
+    if (!n_1.IsScalar() || parsed.size() != value.size() || n < 0) {
+      return zret.error("{} value '{}' at line {} is invalid - it must be a non-negative integer.", PropName[prop], value,
+                        n_1.Mark().line);
+    }
+    count = n;
+  }
+  return zret;
+}
+
+Errata
+Context::load_number(YAML::Node const &node, Property prop, Number &number)
+{
+  Errata zret;
+  if (auto n_1{node[PropName[prop]]}; n_1) {
+    std::string_view value{n_1.IsScalar() ? n_1.Scalar() : std::string_view{}};
+    auto s = value.data();
+    auto e = s + value.size();
+    if (s < e && *s == '+') {
+      ++s;
+    }
+    if (auto [ptr, ec] = std::from_chars(s, e, number.i); ec == std::errc{} && ptr == e) {
+      number.int_p = true;
+      number.d     = double(number.i);
+      swoc::bwprint(number.text, "{}", number.i);
+      if (number.i < std::numeric_limits<int32_t>::min() || std::numeric_limits<int32_t>::max() < number.i) {
+        number.text += "LL";
+      }
+    } else if (auto [ptr, ec] = std::from_chars(s, e, number.d); s < e && ec == std::errc{} && ptr == e && std::isfinite(number.d)) {
+      // Use the shortest text that converts back to the same value.
+      char buff[32];
+      for (int precision = 15; precision <= 17; ++precision) {
+        snprintf(buff, sizeof(buff), "%.*g", precision, number.d);
+        if (strtod(buff, nullptr) == number.d) {
+          break;
+        }
+      }
+      number.text = buff;
+      if (number.text.find_first_of(".e") == std::string::npos) {
+        number.text += ".0";
+      }
+    } else {
+      return zret.error("{} value '{}' at line {} is invalid - it must be a number.", PropName[prop], value, n_1.Mark().line);
+    }
+  }
+  return zret;
+}
+
+Errata
+Context::process_number_value(YAML::Node const &node, std::string_view const &var, std::string_view const &value,
+                              TypeSet const &types)
+{
+  Errata zret;
+  Number minimum, maximum, x_minimum, x_maximum, multiple;
+  bool minimum_p{node[PropName[Property::MINIMUM]]};
+  bool maximum_p{node[PropName[Property::MAXIMUM]]};
+  bool x_minimum_p{false};
+  bool x_maximum_p{false};
+
+  zret.note(load_number(node, Property::MINIMUM, minimum));
+  zret.note(load_number(node, Property::MAXIMUM, maximum));
+  zret.note(load_number(node, Property::MULTIPLE_OF, multiple));
+  // The exclusive bounds are either a flag for the inclusive bound (draft 4) or a separate bound.
+  auto exclusive = [&](Property prop, Number &bound, bool &bound_p, Number &x_bound, bool &x_bound_p) -> void {
+    if (auto n_1{node[PropName[prop]]}; n_1) {
+      if (n_1.IsScalar() && (n_1.Scalar() == "true" || n_1.Scalar() == "false")) {
+        if (n_1.Scalar() == "true") {
+          if (!bound_p) {
+            zret.error("{} at line {} requires a value for {}.", PropName[prop], n_1.Mark().line,
+                       PropName[prop == Property::EXCLUSIVE_MINIMUM ? Property::MINIMUM : Property::MAXIMUM]);
+          }
+          x_bound   = bound;
+          x_bound_p = bound_p;
+          bound_p   = false;
+        }
+      } else {
+        zret.note(load_number(node, prop, x_bound));
+        x_bound_p = true;
+      }
+    }
+  };
+  exclusive(Property::EXCLUSIVE_MINIMUM, minimum, minimum_p, x_minimum, x_minimum_p);
+  exclusive(Property::EXCLUSIVE_MAXIMUM, maximum, maximum_p, x_maximum, x_maximum_p);
+  if (node[PropName[Property::MULTIPLE_OF]] && !(multiple.d > 0)) {
+    zret.error("{} value at line {} is invalid - it must be greater than zero.", PropName[Property::MULTIPLE_OF],
+               node[PropName[Property::MULTIPLE_OF]].Mark().line);
+  }
+  if (zret.severity() >= Severity::ERROR) {
+    return zret;
+  }
+
+  // The checks apply only to numbers, which has already been checked if nothing else is valid.
+  bool guard_p = (types & ~TypeSet{}.set(int(SchemaType::NUMBER)).set(int(SchemaType::INTEGER))).any();
+  if (guard_p) {
+    src_out("if ({}.mask & TYPE_NUMBER) {{\n", value);
+    indent_src();
+  }
+
+  // Integer bounds are compared as integers if the value is an integer, otherwise all comparisons
+  // are floating point.
+  auto bound_check = [&](Number const &bound, std::string_view op, std::string_view msg) -> void {
+    if (bound.int_p) {
+      src_out("if ({0}.int_p ? {0}.i {1} {2} : {0}.d {1} {2}) {{\n", value, op, bound.text);
+    } else {
+      src_out("if ({}.d {} {}) {{\n", value, op, bound.text);
+    }
+    indent_src();
+    emit_error(msg, node, bound.text, var);
+    exdent_src();
+    src_out("}}\n");
+  };
+
+  src_out("// numeric value checks\n");
+  if (minimum_p) {
+    bound_check(minimum, "<", "'#{0}' value '{3}' at line {1} is less than the minimum {2}.");
+  }
+  if (x_minimum_p) {
+    bound_check(x_minimum, "<=", "'#{0}' value '{3}' at line {1} is not greater than the exclusive minimum {2}.");
+  }
+  if (maximum_p) {
+    bound_check(maximum, ">", "'#{0}' value '{3}' at line {1} is greater than the maximum {2}.");
+  }
+  if (x_maximum_p) {
+    bound_check(x_maximum, ">=", "'#{0}' value '{3}' at line {1} is not less than the exclusive maximum {2}.");
+  }
+  if (node[PropName[Property::MULTIPLE_OF]]) {
+    if (multiple.int_p) {
+      src_out("if ({0}.int_p ? {0}.i % {1} != 0 : ! is_multiple({0}.d, {1})) {{\n", value, multiple.text);
+    } else {
+      src_out("if (! is_multiple({}.d, {})) {{\n", value, multiple.text);
+    }
+    indent_src();
+    emit_error("'#{0}' value '{3}' at line {1} is not a multiple of {2}.", node, multiple.text, var);
+    exdent_src();
+    src_out("}}\n");
+  }
+
+  if (guard_p) {
+    exdent_src();
+    src_out("}}\n");
+  }
+  return zret;
+}
+
+Errata
+Context::process_array_value(YAML::Node const &node, std::string_view const &var, TypeSet const &types)
+{
+  Errata zret;
+  int min_items(0), max_items(std::numeric_limits<int>::max());
+
+  bool single_type_p = types.count() == 1;
+  bool has_tags_p =
+    std::any_of(ArrayPropNames.begin(), ArrayPropNames.end(), [&](std::string_view const &name) -> bool { return node[name]; });
+
+  // If this value can only be a single type, then all the type checking needed has already been done
+  // so don't double up on the same check. Otherwise it may not be an array and the array properties
+  // should not be applied.
+  if (!single_type_p && has_tags_p) {
+    src_out("if ({}({})) {{\n", SchemaTypeCheck[SchemaType::ARRAY], var);
+    indent_src();
+  }
+
+  if (node[PropName[Property::MIN_ITEMS]]) {
+    auto n_1       = node[PropName[Property::MIN_ITEMS]];
+    TextView value = TextView{n_1.Scalar()}.trim_if(&isspace);
+    TextView parsed;
+    min_items = swoc::svtoi(value, &parsed);
+    if (parsed.size() != value.size() || min_items < 0) {
+      return zret.error("{} value '{}' at line {} for type {} at line {} is invalid - it "
+                        "must be a positive integer.",
+                        PropName[Property::MIN_ITEMS], value, n_1.Mark().line, SchemaTypeLexicon[SchemaType::ARRAY],
+                        node.Mark().line);
+    }
+    emit_min_items_check(node, var, min_items);
+  }
+
+  if (node[PropName[Property::MAX_ITEMS]]) {
+    auto n_1       = node[PropName[Property::MAX_ITEMS]];
+    TextView value = TextView{n_1.Scalar()}.trim_if(&isspace);
+    TextView parsed;
+    max_items = swoc::svtoi(value, &parsed);
+    if (parsed.size() != value.size() || max_items < 0) {
+      return zret.error("{} value '{}' at line {} for type {} at line {} is invalid - it "
+                        "must be a positive integer.",
+                        PropName[Property::MAX_ITEMS], value, n_1.Mark().line, SchemaTypeLexicon[SchemaType::ARRAY],
+                        node.Mark().line);
+    }
+    emit_max_items_check(node, var, max_items);
+  }
+
+  if (min_items > max_items) {
+    return zret.error("For '{}' value at line {}, the '{}' value at line {} is larger than the '{}' value at line {}.",
+                      SchemaTypeLexicon[SchemaType::ARRAY], node.Mark().line, PropName[Property::MIN_ITEMS],
+                      node[PropName[Property::MIN_ITEMS]].Mark().line, PropName[Property::MAX_ITEMS],
+                      node[PropName[Property::MAX_ITEMS]].Mark().line);
+  }
+
+  // Handle the items in the sequence. Positional schemas are either "items" as an array or
+  // "prefixItems", and the schema for the other items is "additionalItems" or "items" respectively.
+  YAML::Node tuple{YAML::NodeType::Undefined};
+  YAML::Node rest{YAML::NodeType::Undefined};
+  Property rest_prop = Property::ADDITIONAL_ITEMS;
+  auto items_n{node[PropName[Property::ITEMS]]};
+  if (auto n_1{node[PropName[Property::PREFIX_ITEMS]]}; n_1) {
+    if (!n_1.IsSequence()) {
+      return zret.error("'{}' value at line {} is not type {}.", PropName[Property::PREFIX_ITEMS], n_1.Mark().line,
+                        SchemaTypeLexicon[SchemaType::ARRAY]);
+    }
+    if (items_n && items_n.IsSequence()) {
+      return zret.error("'{}' value at line {} must not be an {} if '{}' is used.", PropName[Property::ITEMS], items_n.Mark().line,
+                        SchemaTypeLexicon[SchemaType::ARRAY], PropName[Property::PREFIX_ITEMS]);
+    }
+    tuple.reset(n_1);
+    if (items_n) {
+      rest.reset(items_n);
+      rest_prop = Property::ITEMS;
+    }
+  } else if (items_n && items_n.IsSequence()) {
+    tuple.reset(items_n);
+    if (auto n_2{node[PropName[Property::ADDITIONAL_ITEMS]]}; n_2) {
+      rest.reset(n_2);
+    }
+  } else if (items_n) {
+    rest.reset(items_n);
+    rest_prop = Property::ITEMS;
+  }
+
+  bool closed_p = false;
+  if (rest) {
+    if (rest.IsScalar() && (rest.Scalar() == "true" || rest.Scalar() == "false")) {
+      closed_p = rest.Scalar() == "false";
+      rest.reset(YAML::Node{YAML::NodeType::Undefined});
+    } else if (!rest.IsMap()) {
+      return zret.error("Invalid value for '{}' at line {}: must be a boolean or {}.", PropName[rest_prop], rest.Mark().line,
+                        SchemaTypeLexicon[SchemaType::OBJECT]);
+    }
+  }
+
+  if (tuple) {
+    if (zret.note(process_tuple_value(node, tuple, rest, closed_p, var, max_items)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Failed to process '{}' at line {}.", PropName[Property::ITEMS], tuple.Mark().line);
+    }
+  } else if (closed_p) {
+    emit_max_items_check(node, var, 0);
+  } else if (rest) {
+    // The type values are objects, so each is a schema desciptor.
+    auto nvar = var_name();
+    src_out("size_t {}_idx = 0;\nfor ( auto && {} : {} ) {{\n", nvar, nvar, var);
+    indent_src();
+    src_out("PathGuard<DIAG> {0}_path{{{0}_idx++}};\n", nvar);
+    begin_item();
+    if (zret.note(validate_node(rest, nvar)).severity() >= Severity::ERROR) {
+      zret.note(zret.severity(), "Failed processing '{}' value for '{}' at line {}.", SchemaTypeLexicon[SchemaType::OBJECT],
+                PropName[Property::TYPE], node.Mark().line);
+    }
+    end_item();
+    exdent_src();
+    src_out("}}\n");
+  }
+
+  // Uniqueness is checked after the items so that duplicates are reported only for valid items.
+  if (auto n_1{node[PropName[Property::UNIQUE_ITEMS]]}; n_1) {
+    if (!n_1.IsScalar() || (n_1.Scalar() != "true" && n_1.Scalar() != "false")) {
+      return zret.error("'{}' value at line {} must be a boolean.", PropName[Property::UNIQUE_ITEMS], n_1.Mark().line);
+    }
+    if (n_1.Scalar() == "true") {
+      emit_unique_check(n_1, var, {});
+    }
+  }
+
+  if (auto n_1{node[PropName[Property::UNIQUE_KEY]]}; n_1) {
+    if (!n_1.IsScalar() || n_1.Scalar().empty()) {
+      return zret.error("'{}' value at line {} must be a property name.", PropName[Property::UNIQUE_KEY], n_1.Mark().line);
+    }
+    emit_unique_check(n_1, var, n_1.Scalar());
+  }
+
+  if (!single_type_p && has_tags_p) {
+    exdent_src();
+    src_out("}}\n");
+  }
+
+  if (!zret.empty()) {
+    zret.note(zret.severity(), "Problems procssing '{}' at line {}", PropName[Property::TYPE], node.Mark().line);
+  }
+  return zret;
+}
+
+Errata
+Context::process_tuple_value(YAML::Node const &node, YAML::Node const &tuple, YAML::Node const &rest, bool closed_p,
+                             std::string_view const &var, int max_items)
+{
+  Errata zret;
+  size_t n = tuple.size();
+  if (n > size_t(max_items)) {
+    zret.warn("'{}' at line {} has schemas for {} items but at most {} items are allowed. Extra schemas ignored.",
+              SchemaTypeLexicon[SchemaType::ARRAY], tuple.Mark().line, n, max_items);
+    n = max_items;
+  }
+
+  auto item = var_name();
+  src_out("// positional items\n{{\n");
+  indent_src();
+  src_out("auto {0} = {1}.begin();\nauto const {0}_end = {1}.end();\n", item, var);
+
+  // Items past the positional schemas.
+  auto emit_rest = [&]() -> void {
+    if (closed_p) {
+      std::string arg;
+      src_out("if ({0} != {0}_end) {{\n", item);
+      indent_src();
+      emit_error("Array '#{0}' at line {1} has more than {4} items, the first extra item is at line {5}.", node, {}, var,
+                 std::to_string(n), swoc::bwprint(arg, "{}->Mark().line", item));
+      exdent_src();
+      src_out("}}\n");
+    } else if (rest) {
+      auto nvar = var_name();
+      src_out("for ( size_t {1}_idx = {2} ; {0} != {0}_end ; ++{0}, ++{1}_idx ) {{\n", item, nvar, n);
+      indent_src();
+      src_out("auto const &{} = *{};\n", nvar, item);
+      src_out("PathGuard<DIAG> {0}_path{{{0}_idx}};\n", nvar);
+      begin_item();
+      if (zret.note(validate_node(rest, nvar)).severity() >= Severity::ERROR) {
+        zret.note(zret.severity(), "Failed to process the schema for additional items at line {}.", rest.Mark().line);
+      }
+      end_item();
+      exdent_src();
+      src_out("}}\n");
+    }
+  };
+
+  if (n <= 2) {
+    // Pairs and singletons are unrolled - each item is a straight line step of the iterator.
+    for (size_t idx = 0; idx < n; ++idx) {
+      auto nvar = var_name();
+      src_out("if ({0} != {0}_end) {{\n", item);
+      indent_src();
+      // Scoped so the instance path is only for this item.
+      src_out("{{\n");
+      indent_src();
+      src_out("auto const &{} = *{};\n", nvar, item);
+      src_out("PathGuard<DIAG> {}_path{{size_t({})}};\n", nvar, idx);
+      begin_item();
+      if (zret.note(validate_node(tuple[idx], nvar)).severity() >= Severity::ERROR) {
+        return zret.note(zret.severity(), "Failed to process value {} at line {} for '{}'.", idx, tuple.Mark().line,
+                         PropName[Property::ITEMS]);
+      }
+      end_item();
+      exdent_src();
+      src_out("}}\n++{};\n", item);
+    }
+    emit_rest();
+    for (size_t idx = 0; idx < n; ++idx) {
+      exdent_src();
+      src_out("}}\n");
+    }
+  } else {
+    // One pass over the items, dispatching on position.
+    src_out("for ( size_t idx = 0 ; {0} != {0}_end && idx < {1} ; ++{0}, ++idx ) {{\n", item, n);
+    indent_src();
+    src_out("switch (idx) {{\n");
+    for (size_t idx = 0; idx < n; ++idx) {
+      auto nvar = var_name();
+      src_out("case {}: {{\n", idx);
+      indent_src();
+      src_out("auto const &{} = *{};\n", nvar, item);
+      src_out("PathGuard<DIAG> {}_path{{idx}};\n", nvar);
+      begin_item();
+      if (zret.note(validate_node(tuple[idx], nvar)).severity() >= Severity::ERROR) {
+        return zret.note(zret.severity(), "Failed to process value {} at line {} for '{}'.", idx, tuple.Mark().line,
+                         PropName[Property::ITEMS]);
+      }
+      end_item();
+      src_out("break;\n");
+      exdent_src();
+      src_out("}}\n");
+    }
+    src_out("}}\n");
+    exdent_src();
+    src_out("}}\n");
+    emit_rest();
+  }
+  exdent_src();
+  src_out("}}\n");
+  return zret;
+}
+
+Errata
+Context::process_object_value(YAML::Node const &node, std::string_view const &var, TypeSet const &types)
+{
+  Errata zret;
+  bool single_type_p = types.count() == 1;
+  bool has_tags_p =
+    std::any_of(ObjectPropNames.begin(), ObjectPropNames.end(), [&](std::string_view const &name) -> bool { return node[name]; });
+
+  if (!has_tags_p) {
+    return zret;
+  }
+
+  // Every key of interest gets an index, which is also its bit in the set of keys seen.
+  std::vector<std::string> keys;
+  std::vector<YAML::Node> schemas; // Schema for the key, undefined if none.
+  std::vector<size_t> required;
+  auto key_idx = [&](std::string const &key) -> size_t {
+    auto spot = std::find(keys.begin(), keys.end(), key);
+    if (spot == keys.end()) {
+      keys.push_back(key);
+      schemas.emplace_back(YAML::NodeType::Undefined);
+      return keys.size() - 1;
+    }
+    return spot - keys.begin();
+  };
+
+  if (auto n_1{node[PropName[Property::PROPERTIES]]}; n_1) {
+    if (!n_1.IsMap()) {
+      return zret.error("'{}' value at line {} is not type {}.", PropName[Property::PROPERTIES], n_1.Mark().line,
+                        SchemaTypeLexicon[SchemaType::OBJECT]);
+    }
+    for (auto &&pair : n_1) {
+      schemas[key_idx(pair.first.Scalar())].reset(pair.second);
+    }
+  }
+  // Keys after these are tracked for other checks but are still subject to additional properties.
+  size_t const n_props = keys.size();
+
+  if (auto n_1{node[PropName[Property::REQUIRED]]}; n_1) {
+    if (!n_1.IsSequence()) {
+      return zret.error("'{}' value at line {} is not type {}.", PropName[Property::REQUIRED], n_1.Mark().line,
+                        SchemaTypeLexicon[SchemaType::ARRAY]);
+    }
+    for (auto &&n : n_1) {
+      required.push_back(key_idx(n.Scalar()));
+    }
+  }
+
+  // Dependencies - keys required and schemas applied to the object if a key is present.
+  std::vector<std::pair<size_t, std::vector<size_t>>> dependent_keys;
+  std::vector<std::pair<size_t, YAML::Node>> dependent_schemas;
+  auto load_dependent_keys = [&](std::string const &key, YAML::Node const &n) -> bool {
+    if (!n.IsSequence()) {
+      return false;
+    }
+    auto &[trigger, required_keys] = dependent_keys.emplace_back(key_idx(key), std::vector<size_t>{});
+    for (auto &&k : n) {
+      if (!k.IsScalar()) {
+        return false;
+      }
+      required_keys.push_back(key_idx(k.Scalar()));
+    }
+    return true;
+  };
+  for (auto prop : {Property::DEPENDENT_REQUIRED, Property::DEPENDENT_SCHEMAS, Property::DEPENDENCIES}) {
+    auto n_1{node[PropName[prop]]};
+    if (!n_1) {
+      continue;
+    }
+    if (!n_1.IsMap()) {
+      return zret.error("'{}' value at line {} is not type {}.", PropName[prop], n_1.Mark().line,
+                        SchemaTypeLexicon[SchemaType::OBJECT]);
+    }
+    for (auto &&pair : n_1) {
+      auto const &key = pair.first.Scalar();
+      if (pair.second.IsMap() && prop != Property::DEPENDENT_REQUIRED) {
+        dependent_schemas.emplace_back(key_idx(key), pair.second);
+      } else if (prop == Property::DEPENDENT_SCHEMAS || !load_dependent_keys(key, pair.second)) {
+        return zret.error("'{}' value for '{}' at line {} must be {}.", PropName[prop], key, pair.second.Mark().line,
+                          prop == Property::DEPENDENT_REQUIRED ? "an array of strings"
+                          : prop == Property::DEPENDENT_SCHEMAS ? "a schema"
+                                                                : "a schema or an array of strings");
+      }
+    }
+  }
+
+  // Decoded size check - the keys of the data, its size and its encoding.
+  static constexpr std::array<std::string_view, 3> DECODED_TAGS{{"data", "size", "encoding"}};
+  std::array<std::string, 3> decoded;
+  if (auto n_1{node[PropName[Property::DECODED_SIZE]]}; n_1) {
+    for (unsigned idx = 0; idx < DECODED_TAGS.size(); ++idx) {
+      if (auto n_2{n_1[DECODED_TAGS[idx]]}; n_2 && n_2.IsScalar()) {
+        decoded[idx] = n_2.Scalar();
+        key_idx(decoded[idx]);
+      } else if (n_2 || idx < 2) {
+        return zret.error("'{}' value at line {} must have a '{}' key with a property name.", PropName[Property::DECODED_SIZE],
+                          n_1.Mark().line, DECODED_TAGS[idx]);
+      }
+    }
+  }
+
+  // Keys not listed - false means not allowed, otherwise a schema for the values.
+  YAML::Node additional{YAML::NodeType::Undefined};
+  bool closed_p = false;
+  if (auto n_1{node[PropName[Property::ADDITIONAL_PROPERTIES]]}; n_1) {
+    if (n_1.IsScalar() && n_1.Scalar() == "false") {
+      closed_p = true;
+    } else if (n_1.IsMap()) {
+      additional.reset(n_1);
+    } else if (!n_1.IsScalar() || n_1.Scalar() != "true") {
+      return zret.error("'{}' value at line {} must be a boolean or {}.", PropName[Property::ADDITIONAL_PROPERTIES],
+                        n_1.Mark().line, SchemaTypeLexicon[SchemaType::OBJECT]);
+    }
+  }
+
+  // Key patterns - all are compiled in to a single automaton and each is a bit in the key match
+  // mask. The property name pattern, if any, is last.
+  std::vector<std::string> patterns;
+  std::vector<YAML::Node> pattern_schemas;
+  if (auto n_1{node[PropName[Property::PATTERN_PROPERTIES]]}; n_1) {
+    if (!n_1.IsMap()) {
+      return zret.error("'{}' value at line {} is not type {}.", PropName[Property::PATTERN_PROPERTIES], n_1.Mark().line,
+                        SchemaTypeLexicon[SchemaType::OBJECT]);
+    }
+    for (auto &&pair : n_1) {
+      patterns.push_back(pair.first.Scalar());
+      pattern_schemas.push_back(pair.second);
+    }
+  }
+  uint64_t pattern_mask = pattern_schemas.size() >= 64 ? ~uint64_t(0) : (uint64_t(1) << pattern_schemas.size()) - 1;
+
+  // Schema for keys - if it's just a pattern, that is checked by the key automaton.
+  YAML::Node names{YAML::NodeType::Undefined};
+  bool names_pattern_p = false;
+  if (auto n_1{node[PropName[Property::PROPERTY_NAMES]]}; n_1) {
+    if (!n_1.IsMap()) {
+      return zret.error("'{}' value at line {} is not type {}.", PropName[Property::PROPERTY_NAMES], n_1.Mark().line,
+                        SchemaTypeLexicon[SchemaType::OBJECT]);
+    }
+    if (auto n_2{n_1[PropName[Property::PATTERN]]}; n_2 && n_2.IsScalar() && validation_tag_count(n_1) == 1) {
+      patterns.push_back(n_2.Scalar());
+      names_pattern_p = true;
+    } else {
+      names.reset(n_1);
+    }
+  }
+
+  std::string matcher;
+  if (!patterns.empty() && zret.note(this->matcher(patterns, matcher)).severity() >= Severity::ERROR) {
+    return zret.error("Unable to compile key patterns for value at line {}.", node.Mark().line);
+  }
+
+  int min_props = 0, max_props = std::numeric_limits<int>::max();
+  if (zret.note(load_count(node, Property::MIN_PROPERTIES, min_props)).severity() >= Severity::ERROR ||
+      zret.note(load_count(node, Property::MAX_PROPERTIES, max_props)).severity() >= Severity::ERROR) {
+    return zret;
+  }
+  if (min_props > max_props) {
+    return zret.error("For '{}' value at line {}, the '{}' value is larger than the '{}' value.", SchemaTypeLexicon[SchemaType::OBJECT],
+                      node.Mark().line, PropName[Property::MIN_PROPERTIES], PropName[Property::MAX_PROPERTIES]);
+  }
+  bool count_p = node[PropName[Property::MIN_PROPERTIES]] || node[PropName[Property::MAX_PROPERTIES]];
+
+  if (keys.empty() && !closed_p && !additional && !count_p && patterns.empty() && !names) {
+    return zret;
+  }
+
+  if (!single_type_p) {
+    src_out("if ({}({})) {{\n", SchemaTypeCheck[SchemaType::OBJECT], var);
+    indent_src();
+  }
+
+  // Single pass over the keys of the object, dispatching each key to its checks.
+  auto pvar = var_name();
+  auto nvar = var_name();
+  auto seen = var_name();
+  src_out("// check properties\n{{\n");
+  indent_src();
+  if (count_p) {
+    src_out("size_t key_count = 0;\n");
+  }
+  src_out("std::bitset<{}> {};\n", keys.size(), seen);
+  // Values for the decoded size check, captured during the key dispatch.
+  std::array<std::string, 3> decoded_vars;
+  for (unsigned i = 0; i < decoded.size(); ++i) {
+    if (!decoded[i].empty()) {
+      swoc::bwprint(decoded_vars[i], "{}_{}", seen, DECODED_TAGS[i]);
+      src_out("YAML::Node {};\n", decoded_vars[i]);
+    }
+  }
+  src_out("for ( auto && {} : {} ) {{\n", pvar, var);
+  indent_src();
+  src_out("PathGuard<DIAG> {0}_path{{{0}.first}};\n", pvar);
+  if (count_p) {
+    src_out("++key_count;\n");
+  }
+  begin_item();
+  src_out("int key_idx = -1;\n");
+  if (!patterns.empty()) {
+    src_out("uint64_t key_match = 0;\n");
+  }
+  if (!keys.empty() || !patterns.empty()) {
+    src_out("if ({}.first.IsScalar()) {{\n", pvar);
+    indent_src();
+    src_out("std::string_view key{{{}.first.Scalar()}};\n", pvar);
+    emit_string_dispatch(keys, "key", false, [&](size_t idx) { src_out("key_idx = {};\n", idx); });
+    if (!patterns.empty()) {
+      // One scan of the key for all of the patterns.
+      src_out("key_match = {}(key);\n", matcher);
+    }
+    exdent_src();
+    src_out("}}\n");
+  }
+  if (names_pattern_p) {
+    std::string key;
+    src_out("if ({}.first.IsScalar() && !(key_match & 0x{:x})) {{\n", pvar, uint64_t(1) << (patterns.size() - 1));
+    indent_src();
+    emit_error("Tag '{3}' at line {1} does not match the pattern {2}.", node[PropName[Property::PROPERTY_NAMES]], patterns.back(),
+               swoc::bwprint(key, "{}.first", pvar));
+    exdent_src();
+    src_out("}}\n");
+  } else if (names) {
+    src_out("{{\n");
+    indent_src();
+    src_out("auto const &{} = {}.first;\n", nvar, pvar);
+    if (zret.note(this->validate_node(names, nvar)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Failed to process '{}' at line {}.", PropName[Property::PROPERTY_NAMES], names.Mark().line);
+    }
+    exdent_src();
+    src_out("}}\n");
+  }
+  // Checks for keys that are not properties. If there are pattern properties, these are done after
+  // the pattern checks, otherwise in the switch.
+  auto emit_additional = [&]() -> void {
+    if (closed_p) {
+      std::string key;
+      emit_error("Tag '{3}' at line {1} is not allowed.", node, {}, swoc::bwprint(key, "{}.first", pvar));
+    } else {
+      src_out("auto const &{} = {}.second;\n", nvar, pvar);
+      if (zret.note(this->validate_node(additional, nvar)).severity() >= Severity::ERROR) {
+        zret.note(zret.severity(), "Failed to process '{}' at line {}.", PropName[Property::ADDITIONAL_PROPERTIES],
+                  additional.Mark().line);
+      }
+    }
+  };
+  bool inline_additional_p = (closed_p || additional) && pattern_schemas.empty();
+  src_out("switch (key_idx) {{\n");
+  for (size_t idx = 0; idx < keys.size(); ++idx) {
+    src_out("case {}: {{\n", idx);
+    indent_src();
+    src_out("if ({}[{}]) {{\n", seen, idx);
+    indent_src();
+    std::string key;
+    emit_error("Duplicate tag '{3}' at line {1}.", node, {}, swoc::bwprint(key, "{}.first", pvar));
+    exdent_src();
+    src_out("}}\n");
+    src_out("{}[{}] = true;\n", seen, idx);
+    for (unsigned i = 0; i < decoded.size(); ++i) {
+      if (!decoded[i].empty() && keys[idx] == decoded[i]) {
+        src_out("{}.reset({}.second);\n", decoded_vars[i], pvar);
+      }
+    }
+    if (idx < n_props) {
+      src_out("auto const &{} = {}.second;\n", nvar, pvar);
+      if (zret.note(this->validate_node(schemas[idx], nvar)).severity() >= Severity::ERROR) {
+        return zret.note(zret.severity(), "Failed to process property '{}' at line {}.", keys[idx], schemas[idx].Mark().line);
+      }
+    } else if (inline_additional_p) {
+      emit_additional();
+    }
+    src_out("break;\n");
+    exdent_src();
+    src_out("}}\n");
+  }
+  if (inline_additional_p) {
+    src_out("default: {{\n");
+    indent_src();
+    emit_additional();
+    if (!closed_p) {
+      src_out("break;\n");
+    }
+    exdent_src();
+    src_out("}}\n");
+  }
+  src_out("}}\n");
+  for (size_t idx = 0; idx < pattern_schemas.size(); ++idx) {
+    src_out("if (key_match & 0x{:x}) {{\n", uint64_t(1) << idx);
+    indent_src();
+    src_out("auto const &{} = {}.second;\n", nvar, pvar);
+    if (zret.note(this->validate_node(pattern_schemas[idx], nvar)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Failed to process pattern property '{}' at line {}.", patterns[idx],
+                       pattern_schemas[idx].Mark().line);
+    }
+    exdent_src();
+    src_out("}}\n");
+  }
+  if ((closed_p || additional) && !pattern_schemas.empty()) {
+    src_out("if ((key_idx < 0 || key_idx >= {}) && !(key_match & 0x{:x})) {{\n", n_props, pattern_mask);
+    indent_src();
+    emit_additional();
+    exdent_src();
+    src_out("}}\n");
+  }
+  if (zret.severity() >= Severity::ERROR) {
+    return zret;
+  }
+  end_item();
+  exdent_src();
+  src_out("}}\n");
+
+  if (!required.empty()) {
+    emit_required_check(node, keys, required, seen, var);
+  }
+  for (auto const &[trigger, required_keys] : dependent_keys) {
+    src_out("// check for tags required by '{}'\n", keys[trigger]);
+    src_out("if ({}[{}]) {{\n", seen, trigger);
+    indent_src();
+    emit_bitset_const("dependent_mask", keys.size(), required_keys);
+    src_out("if (({} & dependent_mask) != dependent_mask) {{\n", seen);
+    indent_src();
+    for (auto idx : required_keys) {
+      src_out("if (!{}[{}]) {{\n", seen, idx);
+      indent_src();
+      std::string text;
+      emit_error("Tag {2} was not found in the object '#{0}' at line {1}.", node,
+                 swoc::bwprint(text, "'{}' required by tag '{}'", keys[idx], keys[trigger]), var);
+      exdent_src();
+      src_out("}}\n");
+    }
+    exdent_src();
+    src_out("}}\n");
+    exdent_src();
+    src_out("}}\n");
+  }
+  if (!decoded[0].empty()) {
+    auto const &[data, size, encoding] = decoded;
+    src_out("// check decoded size of '{}'\n", data);
+    src_out("if ({}[{}] && {}[{}]) {{\n", seen, key_idx(data), seen, key_idx(size));
+    indent_src();
+    src_out("auto const &data_n = {};\nauto const &size_n = {};\n", decoded_vars[0], decoded_vars[1]);
+    src_out("std::string_view encoding{{\"plain\"}};\n");
+    if (!encoding.empty()) {
+      src_out("if ({}[{}] && {}.IsScalar()) {{\n  encoding = {}.Scalar();\n}}\n", seen, key_idx(encoding), decoded_vars[2],
+              decoded_vars[2]);
+    }
+    src_out("int64_t expected = -1;\n");
+    src_out("if (data_n.IsScalar() && size_n.IsScalar()) {{\n");
+    indent_src();
+    src_out("auto const &text = size_n.Scalar();\n");
+    src_out("if (auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), expected); ec != std::errc{{}} || "
+            "ptr != text.data() + text.size()) {{\n  expected = -1;\n}}\n");
+    exdent_src();
+    src_out("}}\n");
+    src_out("if (expected >= 0) {{\n");
+    indent_src();
+    src_out("auto size = decoded_size(data_n.Scalar(), encoding);\n");
+    auto decoded_n{node[PropName[Property::DECODED_SIZE]]};
+    src_out("if (size < 0) {{\n");
+    indent_src();
+    src_out("PathGuard<DIAG> data_path{{std::string_view{{R\"uthira({})uthira\"}}}};\n", data);
+    emit_error("'#{0}' value at line {1} is not valid for the encoding in '{2}'.", decoded_n, encoding, "data_n");
+    exdent_src();
+    src_out("}}\nif (size != expected) {{\n");
+    indent_src();
+    src_out("PathGuard<DIAG> size_path{{std::string_view{{R\"uthira({})uthira\"}}}};\n", size);
+    emit_error("'#{0}' value {3} at line {1} does not match the decoded size {4} of the data at line {5}.", decoded_n, {}, "size_n",
+               "size", "data_n.Mark().line");
+    exdent_src();
+    src_out("}}\n");
+    exdent_src();
+    src_out("}}\n");
+    exdent_src();
+    src_out("}}\n");
+    decoded_size_p = true;
+  }
+  for (auto const &[trigger, schema] : dependent_schemas) {
+    src_out("// check schema required by '{}'\n", keys[trigger]);
+    src_out("if ({}[{}]) {{\n", seen, trigger);
+    indent_src();
+    if (zret.note(this->validate_node(schema, var)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Failed to process the schema for '{}' at line {}.", keys[trigger], schema.Mark().line);
+    }
+    exdent_src();
+    src_out("}}\n");
+  }
+  if (node[PropName[Property::MIN_PROPERTIES]]) {
+    src_out("if (key_count < {}) {{\n", min_props);
+    indent_src();
+    emit_error("Object '#{0}' at line {1} has only {4} properties instead of the required {5} properties.", node, {}, var, "key_count",
+               std::to_string(min_props));
+    exdent_src();
+    src_out("}}\n");
+  }
+  if (node[PropName[Property::MAX_PROPERTIES]]) {
+    src_out("if (key_count > {}) {{\n", max_props);
+    indent_src();
+    emit_error("Object '#{0}' at line {1} has {4} properties instead of the maximum {5} properties.", node, {}, var, "key_count",
+               std::to_string(max_props));
+    exdent_src();
+    src_out("}}\n");
+  }
+  exdent_src();
+  src_out("}}\n");
+
+  if (!single_type_p) {
+    exdent_src();
+    src_out("}}\n");
+  }
+  return zret;
+}
+
+Errata
+Context::validate_node(YAML::Node const &value, std::string_view const &var)
+{
+  Errata zret;
+  if (!value.IsMap()) {
+    return zret.error("Value at line {} must be a {}.", value.Mark().line, SchemaTypeLexicon[SchemaType::OBJECT]);
+  }
+
+  if (validation_tag_count(value) == 0) {
+    // Nothing to check, but the node is usually a local alias which would otherwise be unused.
+    src_out("static_cast<void>({}); // Any value is valid.\n", var);
+    return zret;
+  }
+
+  if (auto n{value[REF_KEY]}; n) {
+    if (validation_tag_count(value) > 1) {
+      zret.warn("Ignoring tags in value at line {} - use of '$ref' tag at "
+                "line {} requires ignoring all other tags.",
+                value.Mark().line, n.Mark().line);
+    }
+    if (auto spot = definitions.find(n.Scalar()); spot != definitions.end()) {
+      emit_validator_call(spot->second, var);
+    } else {
+      zret.error("Invalid '$ref' at line {} in value at line {} - '{}' not found.", n.Mark().line, value.Mark().line, n.Scalar());
+    }
+    return zret;
+  }
+
+  // Mergeable allOf branches are checked along with this schema, the rest are checked separately.
+  if (auto n{value[PropName[Property::ALL_OF]]}; n) {
+    YAML::Node merged;
+    std::vector<YAML::Node> rest;
+    if (zret.note(merge_all_of(value, merged, rest)).severity() >= Severity::ERROR ||
+        zret.note(validate_node(merged, var)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Processing '{}' value at line {}", PropName[Property::ALL_OF], n.Mark().line);
+    }
+    for (auto &&branch : rest) {
+      std::string fn;
+      if (zret.note(this->process_branch(branch, "all_of", fn)).severity() >= Severity::ERROR) {
+        return zret.note(zret.severity(), "Processing '{}' value at line {}", PropName[Property::ALL_OF], n.Mark().line);
+      }
+      emit_validator_call(fn, var);
+    }
+    return zret;
+  }
+
+  // Custom checks need to know if any item or property of this node failed.
+  auto check_n{value[PropName[Property::CHECK]]};
+  if (check_n) {
+    auto &flag = _src_frames.back().node_valid.emplace_back();
+    swoc::bwprint(flag, "{}_valid_p", var_name());
+    src_out("[[maybe_unused]] bool {} = true;\n", flag);
+  }
+
+  TypeSet types;
+  auto type_n{value[PropName[Property::TYPE]]};
+  if (type_n) {
+    if (zret.note(process_type_value(type_n, types)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Unable to process value at line {} for '{}' at line {}", type_n.Mark().line,
+                       PropName[Property::TYPE], value.Mark().line);
+    }
+  } else {
+    types.set();
+  }
+
+  // If there are numeric checks, parse the scalar once and use that for the type check as well.
+  std::string scalar_var;
+  if ((types[int(SchemaType::NUMBER)] || types[int(SchemaType::INTEGER)]) &&
+      std::any_of(NumberPropNames.begin(), NumberPropNames.end(), [&](std::string_view const &name) -> bool { return value[name]; })) {
+    swoc::bwprint(scalar_var, "{}_value", var);
+    src_out("auto {} = scalar_value({});\n", scalar_var, var);
+    if (type_n) {
+      std::string mask;
+      emit_type_check(type_n, types, var, swoc::bwprint(mask, "{}.mask", scalar_var));
+    }
+    if (zret.note(process_number_value(value, var, scalar_var, types)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Unable to process value at line {} as {}", value.Mark().line,
+                       SchemaTypeLexicon[SchemaType::NUMBER]);
+    }
+  } else if (type_n) {
+    emit_type_check(type_n, types, var);
+  }
+
+  if (types[int(SchemaType::OBJECT)]) { // could be an object.
+    if (zret.note(process_object_value(value, var, types)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Unable to process value at line {} as {}", value.Mark().line,
+                       SchemaTypeLexicon[SchemaType::OBJECT]);
+    }
+  }
+
+  if (types[int(SchemaType::ARRAY)]) { // could be an array
+    if (zret.note(process_array_value(value, var, types)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Unable to process value at line {}", value.Mark().line);
+    }
+  }
+
+  if (types[int(SchemaType::STRING)] &&
+      std::any_of(StringPropNames.begin(), StringPropNames.end(), [&](std::string_view const &name) -> bool { return value[name]; })) {
+    if (zret.note(process_string_value(value, var, types)).severity() >= Severity::ERROR) {
+      return zret.note(zret.severity(), "Unable to process value at line {} as {}", value.Mark().line,
+                       SchemaTypeLexicon[SchemaType::STRING]);
+    }
+  }
+
+  if (auto n{value[PropName[Property::ANY_OF]]}; n) {
+    if (zret.note(process_any_of_value(n, var)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+  }
+
+  if (auto n{value[PropName[Property::ONE_OF]]}; n) {
+    if (zret.note(process_one_of_value(n, var)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+  }
+
+  auto nocase_n{value[PropName[Property::IGNORE_CASE]]};
+  bool nocase_p = nocase_n && nocase_n.IsScalar() && nocase_n.Scalar() == "true";
+
+  if (auto n{value[PropName[Property::ENUM]]}; n) {
+    if (zret.note(process_enum_value(n, var, nocase_p)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+  }
+
+  if (auto n{value[PropName[Property::CONST]]}; n) {
+    if (zret.note(process_const_value(n, var, nocase_p)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+  }
+
+  if (auto n{value[PropName[Property::PATTERN]]}; n) {
+    if (zret.note(process_pattern_value(n, var)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+  }
+
+  if (auto n{value[PropName[Property::FORMAT]]}; n) {
+    if (zret.note(process_format_value(n, var)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+  }
+
+  if (auto n{value[PropName[Property::NOT]]}; n) {
+    if (zret.note(process_not_value(n, var)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+  }
+
+  if (value[PropName[Property::IF]]) {
+    if (zret.note(process_if_value(value, var)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+  }
+
+  // Custom checks are last so they can assume the node is otherwise valid. Errors in items or
+  // properties don't stop validation if errors are collected, in which case the checks are skipped.
+  if (check_n) {
+    auto flag = std::move(_src_frames.back().node_valid.back());
+    _src_frames.back().node_valid.pop_back();
+    src_out("if ({}) {{\n", flag);
+    indent_src();
+    if (zret.note(process_check_value(check_n, var)).severity() >= Severity::ERROR) {
+      return zret;
+    }
+    exdent_src();
+    src_out("}}\n");
+  }
+
+  return zret;
+}
+
+Rv<YAML::Node> Context::locate(YAML::Node node, TextView path) {
+  Rv<YAML::Node> zret;
+  TextView location { path }; // save original path.
+  while (location) {
+    auto elt { location.take_prefix_at('/') };
+    if (elt.empty() || elt == "#") {
+      node.reset(root_node);
+      continue;
+    }
+    if (node.IsMap()) {
+      if (node[elt]) {
+        node.reset(node[elt]);
+      } else {
+        zret.errata().error(R"("{}" is not in the map {} at {}.)", elt, path.prefix(path.size() - location.size()), node.Mark());
+        break;
+      }
+    } else {
+      zret.errata().error(R"("{}" is not a map.)", path.prefix(path.size() - location.size()));
+      break;
+    }
+  };
+  if (zret.is_ok()) {
+    zret = node;
+  }
+  return std::move(zret);
+}
+
+Errata
+Context::process_definitions(YAML::Node const& node) {
+  Errata erratum;
+  if (node.IsMap()) {
+    if (auto ref_node{node[REF_KEY]} ; ref_node) {
+      if (auto spot = definitions.find(ref_node.Scalar()) ; spot == definitions.end()) {
+        auto def_rv { this->locate(node, ref_node.Scalar()) };
+        if (def_rv.is_ok()) {
+          TextView name { ref_node.Scalar() };
+          if (name.starts_with("#/")) {
+            name.remove_prefix(2);
+          }
+          std::string defun;
+          swoc::bwprint(defun, "v_{}", name);
+          std::transform(defun.begin(), defun.end(), defun.begin(), [](char c) { return isalnum(c) ? c : '_'; });
+          definitions[ref_node.Scalar()] = defun;
+          auto def_idx = definitions.size();
+          // Generate any dependent definitions.
+          erratum.note(this->process_definitions(def_rv));
+          if (erratum.is_ok()) {
+            // Generate this definition. If memoized, the validation is done by a separate function
+            // which is invoked only if there is not already a result for the node.
+            std::string body{memo_p ? defun + "_body" : defun};
+            this->begin_validator(body);
+            erratum.note(validate_node(def_rv, "node"));
+            this->end_validator();
+            if (memo_p) {
+              std::string tmp;
+              auto code = error_code("'#{0}' value at line {1} was previously found invalid for the schema at line {6}.");
+              _src_decls << swoc::bwprint(tmp, "template <bool DIAG> bool {}{};\n", defun, VALIDATOR_SIGNATURE);
+              _src_defs << swoc::bwprint(tmp,
+                                         "template <bool DIAG>\nbool {}{} {{\n  return memo_call<DIAG>({}, {}, {}, &{}<DIAG>, erratum, node, name);\n}}\n\n",
+                                         defun, VALIDATOR_SIGNATURE, def_idx, code, location(def_rv.result(), {}), body);
+            }
+          }
+
+          if (!erratum.is_ok()) {
+            erratum.info(R"(Failed to generate definition "{}" at {}, used at {})", ref_node.Scalar(), def_rv.result(), ref_node.Mark());
+          }
+        } else {
+          erratum.note(def_rv);
+          erratum.error(R"(Unable to find ref "{}" used at {}.)", ref_node.Scalar(), ref_node.Mark());
+        }
+      } // else it's already been processed.
+    } else {
+      for ( [[maybe_unused]] auto const& [ key, value ] : node ) {
+        erratum.note(this->process_definitions(value));
+      }
+    }
+  } else if (node.IsSequence()) {
+    for ( auto const& n : node ) {
+      erratum.note(this->process_definitions(n));
+    }
+  }
+  return erratum;
+}
+
+
+Errata
+process(int argc, char *argv[])
+{
+  int zret;
+  int idx;
+  Context ctx;
+  std::string tmp;
+
+  ctx.class_name = "Schema";
+
+  while (-1 != (zret = getopt_long(argc, argv, ":", Options.data(), &idx))) {
+    switch (zret) {
+    case ':':
+      ctx.notes.error("'{}' requires a value", argv[optind - 1]);
+      break;
+    case 'h':
+      ctx.hdr_path = argv[optind - 1];
+      break;
+    case 's':
+      ctx.src_path = argv[optind - 1];
+      break;
+    case 'c':
+      ctx.class_name = argv[optind - 1];
+      break;
+    case 'm':
+      ctx.memo_p = true;
+      break;
+    case 'i':
+      ctx.includes.emplace_back(argv[optind - 1]);
+      break;
+    default:
+      ctx.notes.warn("Unknown option '{}' - ignored", char(zret), argv[optind - 1]);
+      break;
+    }
+  }
+
+  if (!ctx.notes.is_ok()) {
+    return ctx.notes;
+  }
+
+  if (optind >= argc) {
+    return ctx.notes.error("An input schema file is required");
+  }
+
+  if (ctx.hdr_path.empty()) {
+    if (!ctx.src_path.empty()) {
+      swoc::bwprint(ctx.hdr_path, "{}.h", TextView{ctx.src_path}.remove_suffix_at('.'));
+    } else if (!ctx.class_name.empty()) {
+      swoc::bwprint(ctx.hdr_path, "{}.h", ctx.class_name);
+    } else {
+      return ctx.notes.error("Unable to determine path for output header file.");
+    }
+  }
+
+  if (ctx.src_path.empty()) {
+    if (!ctx.hdr_path.empty()) {
+      swoc::bwprint(ctx.src_path, "{}.cc", TextView{ctx.hdr_path}.remove_suffix_at('.'));
+    } else if (!ctx.class_name.empty()) {
+      swoc::bwprint(ctx.src_path, "{}.cc", ctx.class_name);
+    } else {
+      return ctx.notes.error("Unable to determine path for output source file.");
+    }
+  }
+
+  swoc::file::path schema_path{argv[optind]};
+  std::error_code ec;
+  std::string content = swoc::file::load(schema_path, ec);
+
+  ctx.notes.info("Loaded schema file '{}' - {} bytes", schema_path, content.size());
+
+  YAML::Node root;
+  try {
+    root = YAML::Load(content);
+  } catch (std::exception &ex) {
+    return ctx.notes.error("Loading failed: {}", ex.what());
+  }
+  ctx.root_node.reset(root);
+
+  ctx.hdr_file.open(ctx.hdr_path.c_str(), std::ofstream::trunc);
+  if (!ctx.hdr_file.is_open()) {
+    return ctx.notes.error("Failed to open header output file '{}'", ctx.hdr_path);
+  }
+  ctx.src_file.open(ctx.src_path.c_str(), std::ofstream::trunc);
+  if (!ctx.src_file.is_open()) {
+    return ctx.notes.error("Failed to open source output file '{}'", ctx.src_path);
+  }
+
+  if (!root.IsMap()) {
+    return ctx.notes.error("Root node must be a map");
+  }
+
+  if (auto errata{ctx.process_definitions(root)}; !errata.is_ok()) {
+    return errata;
+  }
+
+  ctx.begin_validator("v_root");
+  ctx.notes.note(ctx.validate_node(root, "node"));
+  ctx.end_validator();
+
+  // The header depends on which features the schema uses, so it is generated last.
+  ctx.hdr_out("#include <cstdint>\n#include <memory>\n#include <memory_resource>\n#include <string>\n#include <string_view>\n#include <vector>\n");
+  if (ctx.ip_format_p) {
+    ctx.hdr_out("#include <functional>\n");
+  }
+  ctx.hdr_out("\n#include \"swoc/Errata.h\"\n");
+  if (ctx.ip_format_p) {
+    ctx.hdr_out("#include \"swoc/swoc_ip.h\"\n");
+  }
+  ctx.hdr_out("#include \"yaml-cpp/yaml.h\"\n\n");
+  ctx.hdr_out("class {} {{\n", ctx.class_name);
+  ctx.indent_hdr();
+  ctx.hdr_out("struct Arena;\n/// Transient memory for validation, released at the start of each validation.\n");
+  ctx.hdr_out("std::unique_ptr<Arena> _arena;\n\n");
+  ctx.exdent_hdr();
+  ctx.hdr_out("public:\n");
+  ctx.indent_hdr();
+  ctx.hdr_out("/// An element of an instance path - an object key, or an array index if @a key is undefined.\n");
+  ctx.hdr_out("struct PathElt {{\n  YAML::Node key{{YAML::NodeType::Undefined}};\n  size_t index = 0;\n}};\n\n");
+  ctx.hdr_out("/// A validation error. The message is rendered from a table only when the error is read.\n");
+  ctx.hdr_out("struct Error {{\n");
+  ctx.indent_hdr();
+  ctx.hdr_out("unsigned code = 0;          ///< Message index.\n");
+  ctx.hdr_out("unsigned location = 0;      ///< Schema location, the same for every error from a check.\n");
+  ctx.hdr_out("YAML::Node node;            ///< The invalid node.\n");
+  ctx.hdr_out("int64_t args[2] = {{0, 0}};   ///< Numeric message arguments.\n");
+  ctx.hdr_out("std::pmr::vector<PathElt> path; ///< Path to @a node from the root.\n");
+  ctx.exdent_hdr();
+  ctx.hdr_out("}};\n\n");
+  ctx.hdr_out("/// Number of errors from a check, if errors are aggregated.\n");
+  ctx.hdr_out("struct ErrorCount {{\n");
+  ctx.indent_hdr();
+  ctx.hdr_out("unsigned code = 0;     ///< Message index.\n");
+  ctx.hdr_out("unsigned location = 0; ///< Schema location.\n");
+  ctx.hdr_out("size_t count = 0;      ///< Number of errors.\n");
+  ctx.exdent_hdr();
+  ctx.hdr_out("}};\n\n");
+  ctx.hdr_out("/// Validation stops after this many errors, 0 for no limit.\n");
+  ctx.hdr_out("size_t max_errors = 1;\n");
+  ctx.hdr_out("/// If not 0, only this many errors are kept for each check and the rest are only counted.\n");
+  ctx.hdr_out("size_t max_instances = 0;\n\n");
+  ctx.hdr_out("// The errors are in the arena and are valid until the next validation.\n");
+  ctx.hdr_out("std::pmr::vector<Error> errors;            ///< Errors from the last validation.\n");
+  ctx.hdr_out("std::pmr::vector<ErrorCount> error_counts; ///< Errors per check from the last validation, if aggregated.\n");
+  ctx.hdr_out("swoc::Errata erratum;                      ///< Messages from custom checks in the last validation.\n");
+  if (ctx.ip_format_p) {
+    ctx.hdr_out("/// Invoked after a successful validation for each value that passes an ip-range or cidr format check,\n");
+    ctx.hdr_out("/// e.g. to fill a swoc::IPSpace. Values checked only by failed combinator branches or by conditions\n");
+    ctx.hdr_out("/// are not reported.\n");
+    ctx.hdr_out("std::function<void(swoc::IPRange const &range, YAML::Node const &node)> ip_range_hook;\n");
+  }
+  ctx.hdr_out("/** Construct a validator.\n *\n * @param upstream Memory for the arena, used only when the arena grows.\n *\n");
+  ctx.hdr_out(" * The arena grows to the memory needed by a validation, after which validating similar documents\n");
+  ctx.hdr_out(" * does not allocate.\n */\n");
+  ctx.hdr_out("explicit {}(std::pmr::memory_resource *upstream = std::pmr::get_default_resource());\n", ctx.class_name);
+  ctx.hdr_out("{0}({0} &&that);\n", ctx.class_name);
+  ctx.hdr_out("/// Not assignable - the results are in the arena, and their containers can't change arenas.\n");
+  ctx.hdr_out("{0} &operator=({0} &&that) = delete;\n", ctx.class_name);
+  ctx.hdr_out("~{}();\n\n", ctx.class_name);
+  ctx.hdr_out("bool operator()(const YAML::Node &n);\n\n", ctx.class_name);
+  ctx.hdr_out("/// Render the messages for @a errors, followed by @a erratum.\n");
+  ctx.hdr_out("swoc::Errata render() const;\n");
+  ctx.hdr_out("/// The message for @a error.\n");
+  ctx.hdr_out("static std::string message(Error const &error);\n");
+  ctx.hdr_out("/// The path to the node of @a error, as a JSON pointer.\n");
+  ctx.hdr_out("static std::string path(Error const &error);\n");
+  ctx.exdent_hdr();
+  ctx.hdr_out("}};\n");
+
+  ctx.src_out("struct {}::Arena : public ArenaResource {{\n  using ArenaResource::ArenaResource;\n}};\n\n", ctx.class_name);
+  ctx.src_out("bool {}::operator()(YAML::Node const& node) {{\n", ctx.class_name);
+  ctx.indent_src();
+  ctx.src_out("Restore transient_guard{{Transient}};\nRestore reporter_guard{{Reporter}};\n");
+  if (ctx.ip_format_p) {
+    ctx.src_out("Restore ip_ranges_guard{{IP_Ranges}};\n");
+  }
+  if (ctx.memo_p) {
+    ctx.src_out("Restore memo_guard{{Memo}};\n");
+  }
+  ctx.src_out("erratum.clear();\n");
+  ctx.src_out("// Drop the results of the previous validation before releasing the arena.\n");
+  ctx.src_out("decltype(errors){{_arena.get()}}.swap(errors);\ndecltype(error_counts){{_arena.get()}}.swap(error_counts);\n");
+  ctx.src_out("_arena->reset();\nTransient = _arena.get();\n");
+  if (ctx.ip_format_p) {
+    // Ranges are collected by the fast pass and reported only if the document is valid.
+    ctx.src_out("IPRanges ranges{{_arena.get()}};\nIP_Ranges = ip_range_hook ? &ranges : nullptr;\n");
+  }
+  if (ctx.memo_p) {
+    ctx.src_out("MemoTable memo{{_arena.get()}};\n");
+    // A cached result would skip the ranges in the node.
+    ctx.src_out(ctx.ip_format_p ? "Memo = IP_Ranges ? nullptr : &memo;\n" : "Memo = &memo;\n");
+  }
+  if (ctx.ip_format_p) {
+    ctx.src_out("bool valid_p = v_root<false>(erratum, node, \"root\");\nIP_Ranges = nullptr;\n");
+    ctx.src_out("if (valid_p) {{\n  for (auto const &[range, n] : ranges) {{\n    ip_range_hook(range, n);\n  }}\n  return true;\n}}\n");
+  } else {
+    ctx.src_out("if (v_root<false>(erratum, node, \"root\")) {{\n  return true;\n}}\n");
+  }
+  // The document is not valid, validate again to generate the diagnostics.
+  ctx.src_out("erratum.clear();\n");
+  if (ctx.memo_p) {
+    ctx.src_out("memo.clear();\n");
+  }
+  ctx.src_out("Report report{{errors, error_counts, max_errors, max_instances, _arena.get()}};\nReporter = &report;\n");
+  ctx.src_out("return v_root<true>(erratum, node, \"root\");\n");
+  ctx.exdent_src();
+  ctx.src_out("}}\n\n");
+
+  ctx.src_out("{0}::{0}(std::pmr::memory_resource *upstream) : _arena(new Arena(upstream)), errors(_arena.get()), "
+              "error_counts(_arena.get()) {{}}\n\n",
+              ctx.class_name);
+  ctx.src_out("// Defined here, where the arena type is complete.\n{0}::{0}({0} &&that) = default;\n{0}::~{0}() = default;\n\n",
+              ctx.class_name);
+
+  // The message and location tables are shared by all of the checks, and used only to render errors.
+  ctx.src_out("namespace {{\n/// Error messages, indexed by error code.\n");
+  ctx.src_out("constexpr std::array<std::string_view, {}> Messages{{{{\n", ctx.messages.size());
+  for (auto const &msg : ctx.messages) {
+    ctx.src_out("  R\"uthira({})uthira\",\n", msg);
+  }
+  ctx.src_out("}}}};\n/// Schema locations of errors - the schema line and the text for the message.\n");
+  ctx.src_out("constexpr std::array<std::pair<int, std::string_view>, {}> Locations{{{{\n", ctx.locations.size());
+  for (auto const &[line, text] : ctx.locations) {
+    ctx.src_out("  {{{}, R\"uthira({})uthira\"}},\n", line, text);
+  }
+  ctx.src_out("}}}};\n}} // namespace\n\n");
+
+  ctx.src_out("swoc::Errata {}::render() const {{\n", ctx.class_name);
+  ctx.indent_src();
+  ctx.src_out("swoc::Errata zret;\nfor (auto const &error : errors) {{\n  zret.error(\"{{}}\", message(error));\n}}\n");
+  ctx.src_out("for (auto const &[code, location, count] : error_counts) {{\n");
+  ctx.indent_src();
+  ctx.src_out("if (count > max_instances) {{\n");
+  ctx.indent_src();
+  ctx.src_out("auto spot = std::find_if(errors.begin(), errors.end(), [&](Error const &error) {{ return error.code == code && "
+              "error.location == location; }});\n");
+  ctx.src_out("zret.error(\"{{}} more errors like: {{}}\", count - max_instances, message(*spot));\n");
+  ctx.exdent_src();
+  ctx.src_out("}}\n");
+  ctx.exdent_src();
+  ctx.src_out("}}\n");
+  ctx.src_out("zret.note(erratum);\nreturn zret;\n");
+  ctx.exdent_src();
+  ctx.src_out("}}\n\n");
+
+  ctx.src_out("std::string {}::message(Error const &error) {{\n", ctx.class_name);
+  ctx.indent_src();
+  ctx.src_out("std::string zret;\nauto const &[line, text] = Locations[error.location];\n");
+  ctx.src_out("swoc::bwprint(zret, Messages[error.code], path(error), error.node.Mark().line, text, node_text(error.node), "
+              "error.args[0], error.args[1], line);\n");
+  ctx.src_out("return zret;\n");
+  ctx.exdent_src();
+  ctx.src_out("}}\n\n");
+
+  ctx.src_out("std::string {}::path(Error const &error) {{\n", ctx.class_name);
+  ctx.indent_src();
+  ctx.src_out("std::string zret;\nfor (auto const &elt : error.path) {{\n");
+  ctx.indent_src();
+  ctx.src_out("zret += '/';\nif (!elt.key.IsDefined()) {{\n  zret += std::to_string(elt.index);\n  continue;\n}}\n");
+  ctx.src_out("// Escape per RFC 6901.\nfor (char c : node_text(elt.key)) {{\n");
+  ctx.src_out("  zret += c == '~' ? \"~0\" : c == '/' ? \"~1\" : std::string_view{{&c, 1}};\n}}\n");
+  ctx.exdent_src();
+  ctx.src_out("}}\nreturn zret;\n");
+  ctx.exdent_src();
+  ctx.src_out("}}\n");
+
+  // Assemble the source file.
+  ctx.src_file << swoc::bwprint(tmp,
+                                "#include <array>\n#include <algorithm>\n#include <bitset>\n#include <iostream>\n#include <cstdint>\n"
+                                "#include <charconv>\n#include <cmath>\n#include <cstring>\n#include <optional>\n#include <strings.h>\n"
+                                "#include <unordered_map>\n\n"
+                                "#include \"{}\"\n",
+                                ctx.hdr_path);
+  for (auto const &path : ctx.includes) {
+    ctx.src_file << swoc::bwprint(tmp, "#include \"{}\"\n", path);
+  }
+
+  // These are hand rolled functions used by the generated code.
+  ctx.src_file << (R"racecar(
+namespace {
+
+/** Monotonic arena for the transient memory of a validation.
+ *
+ * Memory is released only by @c reset. The initial buffer is grown to the memory used by the previous
+ * validation, so validating documents of similar size does not use the upstream resource.
+ */
+class ArenaResource : public std::pmr::memory_resource
+{
+public:
+  explicit ArenaResource(std::pmr::memory_resource *upstream) : _overflow(upstream) { _monotonic.emplace(&_overflow); }
+  ~ArenaResource() override
+  {
+    _monotonic.reset();
+    if (_buffer) {
+      _overflow.upstream->deallocate(_buffer, _size);
+    }
+  }
+
+  /// Release all memory.
+  void
+  reset()
+  {
+    _monotonic.reset();
+    if (_overflow.bytes > 0) {
+      if (_buffer) {
+        _overflow.upstream->deallocate(_buffer, _size);
+      }
+      _size += _overflow.bytes;
+      _buffer         = _overflow.upstream->allocate(_size);
+      _overflow.bytes = 0;
+    }
+    if (_buffer) {
+      _monotonic.emplace(_buffer, _size, &_overflow);
+    } else {
+      _monotonic.emplace(&_overflow);
+    }
+  }
+
+protected:
+  void *
+  do_allocate(size_t n, size_t align) override
+  {
+    return _monotonic->allocate(n, align);
+  }
+  void
+  do_deallocate(void *, size_t, size_t) override
+  {
+  }
+  bool
+  do_is_equal(std::pmr::memory_resource const &that) const noexcept override
+  {
+    return this == &that;
+  }
+
+  /// Upstream for memory past the initial buffer, which tracks how much was needed.
+  struct Overflow : public std::pmr::memory_resource {
+    explicit Overflow(std::pmr::memory_resource *r) : upstream(r) {}
+    std::pmr::memory_resource *upstream;
+    size_t bytes = 0;
+
+    void *
+    do_allocate(size_t n, size_t align) override
+    {
+      bytes += n;
+      return upstream->allocate(n, align);
+    }
+    void
+    do_deallocate(void *p, size_t n, size_t align) override
+    {
+      upstream->deallocate(p, n, align);
+    }
+    bool
+    do_is_equal(std::pmr::memory_resource const &that) const noexcept override
+    {
+      return this == &that;
+    }
+  } _overflow;
+
+  void *_buffer = nullptr; ///< Initial buffer.
+  size_t _size  = 0;       ///< Size of @a _buffer.
+  std::optional<std::pmr::monotonic_buffer_resource> _monotonic;
+};
+
+/// Transient memory for the current validation.
+thread_local std::pmr::memory_resource *Transient = nullptr;
+
+/** Restore a variable of the validation state when a validation returns.
+ *
+ * The state is per thread, and a validation can be nested in another, e.g. by a custom check that
+ * uses another validator.
+ */
+template <typename T> struct Restore {
+  explicit Restore(T &var) : _var(var), _value(var) {}
+  Restore(Restore const &)            = delete;
+  Restore &operator=(Restore const &) = delete;
+  ~Restore() { _var = _value; }
+
+  T &_var;  ///< Variable to restore.
+  T _value; ///< Value to restore.
+};
+
+uint64_t
+hash_mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Structural hash - must be identical to the hash used by the code generator.
+uint64_t
+node_hash(YAML::Node const &node)
+{
+  switch (node.Type()) {
+  case YAML::NodeType::Scalar: {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : node.Scalar()) {
+      h = (h ^ c) * 0x100000001b3ULL;
+    }
+    return hash_mix(h);
+  }
+  case YAML::NodeType::Sequence: {
+    uint64_t h = 3;
+    for (auto const &n : node) {
+      h = hash_mix(h + node_hash(n));
+    }
+    return h;
+  }
+  case YAML::NodeType::Map: {
+    uint64_t h = 0;
+    for (auto const &pair : node) {
+      h += hash_mix(node_hash(pair.first) * 31 + node_hash(pair.second));
+    }
+    return hash_mix(h ^ 4);
+  }
+  default:
+    break;
+  }
+  return hash_mix(1);
+}
+
+bool
+equal(const YAML::Node &lhs, const YAML::Node &rhs)
+{
+  if (lhs.Type() != rhs.Type()) {
+    return false;
+  }
+  if (lhs.IsSequence()) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    for (auto l = lhs.begin(), r = rhs.begin(); l != lhs.end(); ++l, ++r) {
+      if (!equal(*l, *r)) {
+        return false;
+      }
+    }
+  } else if (lhs.IsMap()) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    // Keys are usually in the same order, so walk both maps and search only on a key mismatch.
+    for (auto l = lhs.begin(), r = rhs.begin(); l != lhs.end(); ++l, ++r) {
+      if (equal(l->first, r->first)) {
+        if (!equal(l->second, r->second)) {
+          return false;
+        }
+      } else {
+        auto spot = std::find_if(rhs.begin(), rhs.end(), [&](auto const &pair) { return equal(l->first, pair.first); });
+        if (spot == rhs.end() || !equal(l->second, spot->second)) {
+          return false;
+        }
+      }
+    }
+  } else if (lhs.IsScalar()) {
+    return lhs.Scalar() == rhs.Scalar();
+  }
+  return true;
+}
+
+/** Find duplicate items in the sequence @a node.
+ *
+ * If @a key is empty items are compared structurally, otherwise the values of @a key in object items
+ * are compared and items without that key are skipped. Returns the indices of the first occurrence
+ * and the first duplicate of it, with the latter zero if there are no duplicates.
+ */
+[[maybe_unused]] std::pair<size_t, size_t>
+find_duplicate(YAML::Node const &node, std::string_view key)
+{
+  std::pmr::unordered_multimap<uint64_t, size_t> seen{Transient};
+  std::pmr::vector<YAML::Node> values{Transient};
+  seen.reserve(node.size());
+  values.reserve(node.size());
+  std::string const key_text{key};
+  for (YAML::Node const &item : node) {
+    YAML::Node value = item;
+    if (!key.empty()) {
+      // Const lookup, so a missing key is not added to the item.
+      auto n = item.IsMap() ? item[key_text] : YAML::Node{YAML::NodeType::Undefined};
+      if (!n) {
+        values.emplace_back();
+        continue;
+      }
+      value.reset(n); // assignment would overwrite the item.
+    }
+    auto h            = node_hash(value);
+    auto [spot, last] = seen.equal_range(h);
+    for (; spot != last; ++spot) {
+      if (equal(values[spot->second], value)) {
+        return {spot->second, values.size()};
+      }
+    }
+    seen.emplace(h, values.size());
+    values.push_back(value);
+  }
+  return {0, 0};
+}
+
+// Type bits - these must match the @c SchemaType values in the code generator.
+constexpr unsigned TYPE_NULL    = 1 << 0;
+constexpr unsigned TYPE_BOOL    = 1 << 1;
+constexpr unsigned TYPE_OBJECT  = 1 << 2;
+constexpr unsigned TYPE_ARRAY   = 1 << 3;
+constexpr unsigned TYPE_NUMBER  = 1 << 4;
+constexpr unsigned TYPE_INTEGER = 1 << 5;
+constexpr unsigned TYPE_STRING  = 1 << 6;
+
+// Check 8 characters at once for all being decimal digits.
+inline bool
+swar_digits(uint64_t w)
+{
+  return ((w & 0xF0F0F0F0F0F0F0F0ULL) | (((w + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+// Count the leading decimal digits in @a s.
+size_t
+digit_span(char const *s, size_t n)
+{
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t w;
+    memcpy(&w, s + i, sizeof(w));
+    if (!swar_digits(w)) {
+      break;
+    }
+  }
+  while (i < n && '0' <= s[i] && s[i] <= '9') {
+    ++i;
+  }
+  return i;
+}
+
+bool
+all_radix_digits(char const *s, size_t n, bool hex_p)
+{
+  for (; n > 0; ++s, --n) {
+    char c = *s;
+    if (!(('0' <= c && c <= '7') || (hex_p && (('8' <= c && c <= '9') || ('a' <= c && c <= 'f') || ('A' <= c && c <= 'F'))))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Classify a scalar per the YAML 1.2 core schema. Every scalar is a string, some are also other types.
+unsigned
+scalar_type_mask(YAML::Node const &node)
+{
+  unsigned mask = TYPE_STRING;
+  // Quoted scalars are always strings.
+  if (node.Tag() == "!") {
+    return mask;
+  }
+  auto const &text = node.Scalar();
+  auto s           = text.data();
+  auto n           = text.size();
+  if (n == 0) {
+    return mask;
+  }
+  switch (s[0]) {
+  case 't':
+  case 'T':
+    if (n == 4 && (0 == memcmp(s, "true", 4) || 0 == memcmp(s, "True", 4) || 0 == memcmp(s, "TRUE", 4))) {
+      mask |= TYPE_BOOL;
+    }
+    return mask;
+  case 'f':
+  case 'F':
+    if (n == 5 && (0 == memcmp(s, "false", 5) || 0 == memcmp(s, "False", 5) || 0 == memcmp(s, "FALSE", 5))) {
+      mask |= TYPE_BOOL;
+    }
+    return mask;
+  case '0':
+    if (n > 2 && (s[1] == 'x' || s[1] == 'o')) {
+      if (all_radix_digits(s + 2, n - 2, s[1] == 'x')) {
+        mask |= TYPE_INTEGER | TYPE_NUMBER;
+      }
+      return mask;
+    }
+    break;
+  case '-':
+  case '+':
+    ++s, --n;
+    break;
+  }
+  // Number - [0-9]+ for integers, else [0-9]*(\.[0-9]*)?([eE][-+]?[0-9]+)? with at least one mantissa digit.
+  auto int_n = digit_span(s, n);
+  if (int_n == n) {
+    if (n > 0) {
+      mask |= TYPE_INTEGER | TYPE_NUMBER;
+    }
+    return mask;
+  }
+  auto i        = int_n;
+  size_t frac_n = 0;
+  if (s[i] == '.') {
+    ++i;
+    frac_n = digit_span(s + i, n - i);
+    i += frac_n;
+  }
+  if (int_n + frac_n == 0) {
+    return mask;
+  }
+  if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+    ++i;
+    if (i < n && (s[i] == '-' || s[i] == '+')) {
+      ++i;
+    }
+    auto exp_n = digit_span(s + i, n - i);
+    if (exp_n == 0) {
+      return mask;
+    }
+    i += exp_n;
+  }
+  if (i == n) {
+    mask |= TYPE_NUMBER;
+  }
+  return mask;
+}
+
+// Compute the set of schema types for which @a node is valid.
+unsigned
+type_mask(YAML::Node const &node)
+{
+  switch (node.Type()) {
+  case YAML::NodeType::Null:
+    return TYPE_NULL;
+  case YAML::NodeType::Scalar:
+    return scalar_type_mask(node);
+  case YAML::NodeType::Sequence:
+    return TYPE_ARRAY;
+  case YAML::NodeType::Map:
+    return TYPE_OBJECT;
+  default:
+    break;
+  }
+  return 0;
+}
+
+/// A scalar classified by type and, if a number, converted to a value.
+struct ScalarValue {
+  unsigned mask = 0;     ///< Type mask.
+  bool int_p    = false; ///< Value is an integer that fits in @a i.
+  int64_t i     = 0;     ///< Integer value.
+  double d      = 0;     ///< Value as a floating point number.
+};
+
+// Classify and convert @a node. This is done once for all of the type and value checks.
+[[maybe_unused]] ScalarValue
+scalar_value(YAML::Node const &node)
+{
+  ScalarValue zret;
+  zret.mask = type_mask(node);
+  if (zret.mask & TYPE_NUMBER) {
+    auto const &text = node.Scalar();
+    auto s           = text.data();
+    auto e           = s + text.size();
+    if (*s == '+') {
+      ++s;
+    }
+    if (zret.mask & TYPE_INTEGER) {
+      int base = 10;
+      if (e - s > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'o')) {
+        base = s[1] == 'x' ? 16 : 8;
+        s += 2;
+      }
+      auto [ptr, ec] = std::from_chars(s, e, zret.i, base);
+      if (ec == std::errc{} && ptr == e) {
+        zret.int_p = true;
+        zret.d     = double(zret.i);
+        return zret;
+      }
+      if (base != 10) { // too large, but still valid.
+        for (; s < e; ++s) {
+          zret.d = zret.d * base + (*s <= '9' ? *s - '0' : (*s | 0x20) - 'a' + 10);
+        }
+        return zret;
+      }
+    }
+    if (auto [ptr, ec] = std::from_chars(s, e, zret.d); ec == std::errc::result_out_of_range) {
+      zret.d = std::strtod(text.c_str(), nullptr);
+    }
+  }
+  return zret;
+}
+
+// Check if @a value is a multiple of @a m, allowing for rounding.
+[[maybe_unused]] bool
+is_multiple(double value, double m)
+{
+  double q = value / m;
+  return std::abs(q - std::nearbyint(q)) <= 1e-9 * std::max(1.0, std::abs(q));
+}
+
+// UTF-8 lead bytes - the sequence length and the valid range of the second byte. Zero length marks
+// bytes that can't start a sequence, which excludes overlong encodings and surrogates.
+struct Utf8Lead {
+  uint8_t len;
+  uint8_t lo;
+  uint8_t hi;
+};
+
+constexpr std::array<Utf8Lead, 256> Utf8_Lead = []() {
+  std::array<Utf8Lead, 256> table{};
+  for (int c = 0xC2; c <= 0xDF; ++c) {
+    table[c] = {2, 0x80, 0xBF};
+  }
+  for (int c = 0xE0; c <= 0xEF; ++c) {
+    table[c] = {3, 0x80, 0xBF};
+  }
+  table[0xE0] = {3, 0xA0, 0xBF};
+  table[0xED] = {3, 0x80, 0x9F};
+  for (int c = 0xF0; c <= 0xF4; ++c) {
+    table[c] = {4, 0x80, 0xBF};
+  }
+  table[0xF0] = {4, 0x90, 0xBF};
+  table[0xF4] = {4, 0x80, 0x8F};
+  return table;
+}();
+
+// Count the code points in @a text, or -1 if it is not valid UTF-8. ASCII is handled 8 bytes at a time.
+[[maybe_unused]] int64_t
+utf8_length(std::string_view text)
+{
+  constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+  auto s     = reinterpret_cast<uint8_t const *>(text.data());
+  size_t n   = text.size();
+  size_t i   = 0;
+  int64_t cp = 0;
+  while (i < n) {
+    if (i + 8 <= n) {
+      uint64_t w;
+      memcpy(&w, s + i, sizeof(w));
+      if ((w & HIGH_BITS) == 0) {
+        i  += 8;
+        cp += 8;
+        continue;
+      }
+    }
+    auto c = s[i];
+    if (c < 0x80) {
+      ++i;
+    } else {
+      auto const &lead = Utf8_Lead[c];
+      if (lead.len == 0 || i + lead.len > n || s[i + 1] < lead.lo || s[i + 1] > lead.hi) {
+        return -1;
+      }
+      for (unsigned k = 2; k < lead.len; ++k) {
+        if ((s[i + k] & 0xC0) != 0x80) {
+          return -1;
+        }
+      }
+      i += lead.len;
+    }
+    ++cp;
+  }
+  return cp;
+}
+
+[[maybe_unused]] bool is_null_type(YAML::Node const& node) {
+  return node.IsNull();
+}
+
+[[maybe_unused]] bool is_bool_type(YAML::Node const& node) {
+  return node.IsScalar() && (scalar_type_mask(node) & TYPE_BOOL);
+}
+
+[[maybe_unused]] bool is_array_type(YAML::Node const& node) {
+  return node.IsSequence();
+}
+
+[[maybe_unused]] bool is_object_type(YAML::Node const& node) {
+  return node.IsMap();
+}
+
+[[maybe_unused]] bool is_integer_type(YAML::Node const& node) {
+  return node.IsScalar() && (scalar_type_mask(node) & TYPE_INTEGER);
+}
+
+[[maybe_unused]] bool is_number_type(YAML::Node const& node) {
+  return node.IsScalar() && (scalar_type_mask(node) & TYPE_NUMBER);
+}
+
+[[maybe_unused]] bool is_string_type(YAML::Node const& node) {
+  return node.IsScalar();
+}
+
+} // namespace
 
-  ctx.class_name = "Schema";
+)racecar");
 
-  while (-1 != (zret = getopt_long(argc, argv, ":", Options.data(), &idx))) {
-    switch (zret) {
-    case ':':
-      ctx.notes.error("'{}' requires a value", argv[optind - 1]);
-      break;
-    case 'h':
-      ctx.hdr_path = argv[optind - 1];
-      break;
-    case 's':
-      ctx.src_path = argv[optind - 1];
-      break;
-    case 'c':
-      ctx.class_name = argv[optind - 1];
-      break;
-    default:
-      ctx.notes.warn("Unknown option '{}' - ignored", char(zret), argv[optind - 1]);
-      break;
-    }
+  // Error reporting - the types are those of the generated class.
+  ctx.src_file << swoc::bwprint(tmp,
+                                "namespace {{\nusing Error      = {0}::Error;\nusing ErrorCount = {0}::ErrorCount;\n"
+                                "using PathElt    = {0}::PathElt;\n}} // namespace\n",
+                                ctx.class_name);
+  ctx.src_file << (R"racecar(
+namespace {
+
+/// Error state for the current diagnostic validation.
+struct Report {
+  Report(std::pmr::vector<Error> &e, std::pmr::vector<ErrorCount> &c, size_t max_e, size_t max_i, std::pmr::memory_resource *arena)
+    : errors(e), counts(c), max_errors(max_e), max_instances(max_i), path(arena), pending(arena), groups(arena)
+  {
   }
 
-  if (!ctx.notes.is_ok()) {
-    return ctx.notes;
+  std::pmr::vector<Error> &errors;      ///< Errors kept.
+  std::pmr::vector<ErrorCount> &counts; ///< Error counts per check, if aggregated.
+  size_t max_errors;                    ///< Error budget, 0 for no limit.
+  size_t max_instances;                 ///< Errors kept per check, 0 to keep all.
+  size_t total   = 0;                   ///< Errors outside of combinator branches.
+  unsigned depth = 0;                   ///< Nesting depth of combinator branches.
+  /// Path to the node being validated.
+  std::pmr::vector<PathElt> path;
+  /// Errors in combinator branches, which are discarded if the combinator is valid.
+  std::pmr::vector<Error> pending;
+  /// Index in @a counts for each check, keyed by the code and location.
+  std::pmr::unordered_map<uint64_t, size_t> groups;
+};
+thread_local Report *Reporter = nullptr;
+
+/// Count an error for the check, and return whether the error should be kept.
+bool
+count_error(unsigned code, unsigned location)
+{
+  ++Reporter->total;
+  if (Reporter->max_instances == 0) {
+    return true;
   }
+  auto [spot, added_p] = Reporter->groups.emplace((uint64_t(code) << 32) | location, Reporter->counts.size());
+  if (added_p) {
+    Reporter->counts.push_back({code, location, 0});
+  }
+  return ++Reporter->counts[spot->second].count <= Reporter->max_instances;
+}
 
-  if (optind >= argc) {
-    return ctx.notes.error("An input schema file is required");
+/// Whether to continue validation after an error in an item or property. The fast variant stops at the
+/// first error, as does validation inside a combinator branch.
+template <bool DIAG>
+bool
+keep_going()
+{
+  if constexpr (DIAG) {
+    return Reporter->depth == 0 && (Reporter->max_errors == 0 || Reporter->total < Reporter->max_errors);
   }
+  return false;
+}
 
-  if (ctx.hdr_path.empty()) {
-    if (!ctx.src_path.empty()) {
-      swoc::bwprint(ctx.hdr_path, "{}.h", TextView{ctx.src_path}.remove_suffix_at('.'));
-    } else if (!ctx.class_name.empty()) {
-      swoc::bwprint(ctx.hdr_path, "{}.h", ctx.class_name);
-    } else {
-      return ctx.notes.error("Unable to determine path for output header file.");
-    }
+/// Keep an object key or array index on the instance path for the scope of the guard.
+template <bool DIAG> struct PathGuard {
+  explicit PathGuard(YAML::Node const &) {}
+  explicit PathGuard(std::string_view) {}
+  explicit PathGuard(size_t) {}
+};
+
+template <> struct PathGuard<true> {
+  explicit PathGuard(YAML::Node const &key) { Reporter->path.push_back({key, 0}); }
+  explicit PathGuard(std::string_view key) { Reporter->path.push_back({YAML::Node(std::string(key)), 0}); }
+  explicit PathGuard(size_t idx) { Reporter->path.push_back({YAML::Node(YAML::NodeType::Undefined), idx}); }
+  PathGuard(PathGuard const &) = delete;
+  PathGuard &operator=(PathGuard const &) = delete;
+  ~PathGuard() { Reporter->path.pop_back(); }
+};
+
+/// Start the branches of a combinator. The errors of the branches are held until it is known whether
+/// the combinator is valid.
+template <bool DIAG>
+size_t
+begin_branches()
+{
+  if constexpr (DIAG) {
+    ++Reporter->depth;
+    return Reporter->pending.size();
   }
+  return 0;
+}
 
-  if (ctx.src_path.empty()) {
-    if (!ctx.hdr_path.empty()) {
-      swoc::bwprint(ctx.src_path, "{}.cc", TextView{ctx.hdr_path}.remove_suffix_at('.'));
-    } else if (!ctx.class_name.empty()) {
-      swoc::bwprint(ctx.src_path, "{}.cc", ctx.class_name);
-    } else {
-      return ctx.notes.error("Unable to determine path for output source file.");
+/// Finish the branches of a combinator, keeping the errors after @a mark if @a keep_p.
+[[maybe_unused]] void
+end_branches(size_t mark, bool keep_p)
+{
+  auto &pending = Reporter->pending;
+  if (--Reporter->depth == 0 && keep_p) {
+    for (auto spot = pending.begin() + mark; spot != pending.end(); ++spot) {
+      if (count_error(spot->code, spot->location)) {
+        Reporter->errors.push_back(std::move(*spot));
+      }
     }
+  } else if (keep_p) {
+    return; // The enclosing combinator decides.
+  }
+  pending.erase(pending.begin() + mark, pending.end());
+}
+
+/// Record an error for @a node. Only the path is copied, the message is rendered later if needed.
+void
+report(unsigned code, unsigned location, YAML::Node const &node, int64_t arg_0, int64_t arg_1)
+{
+  if (Reporter->depth > 0) {
+    Reporter->pending.push_back(Error{code, location, node, {arg_0, arg_1}, {Reporter->path, Transient}});
+  } else if (count_error(code, location)) {
+    Reporter->errors.push_back(Error{code, location, node, {arg_0, arg_1}, {Reporter->path, Transient}});
   }
+}
 
-  swoc::file::path schema_path{argv[optind]};
-  std::error_code ec;
-  std::string content = swoc::file::load(schema_path, ec);
+/// Text of @a node for messages.
+std::string
+node_text(YAML::Node const &node)
+{
+  if (node.IsScalar()) {
+    return node.Scalar();
+  }
+  YAML::Emitter yem;
+  yem << node;
+  return yem.c_str();
+}
 
-  ctx.notes.info("Loaded schema file '{}' - {} bytes", schema_path, content.size());
+} // namespace
 
-  YAML::Node root;
-  try {
-    root = YAML::Load(content);
-  } catch (std::exception &ex) {
-    return ctx.notes.error("Loading failed: {}", ex.what());
+)racecar");
+
+  if (ctx.ip_format_p) {
+    ctx.src_file << (R"racecar(namespace {
+
+using IPRanges = std::pmr::vector<std::pair<swoc::IPRange, YAML::Node>>;
+
+/// Ranges found by the current validation, if they are reported.
+thread_local IPRanges *IP_Ranges = nullptr;
+
+bool
+ip_range_found(swoc::IPRange const &range, YAML::Node const &node)
+{
+  if (IP_Ranges) {
+    IP_Ranges->emplace_back(range, node);
   }
-  ctx.root_node.reset(root);
+  return true;
+}
 
-  ctx.hdr_file.open(ctx.hdr_path.c_str(), std::ofstream::trunc);
-  if (!ctx.hdr_file.is_open()) {
-    return ctx.notes.error("Failed to open header output file '{}'", ctx.hdr_path);
+/// Validate a combinator branch, dropping the ranges it found if it is not valid.
+template <typename F>
+bool
+branch_call(F fn, swoc::Errata &erratum, YAML::Node const &node, std::string_view const &name)
+{
+  auto mark    = IP_Ranges ? IP_Ranges->size() : 0;
+  bool valid_p = fn(erratum, node, name);
+  if (!valid_p && IP_Ranges) {
+    IP_Ranges->erase(IP_Ranges->begin() + mark, IP_Ranges->end());
   }
-  ctx.src_file.open(ctx.src_path.c_str(), std::ofstream::trunc);
-  if (!ctx.src_file.is_open()) {
-    return ctx.notes.error("Failed to open source output file '{}'", ctx.src_path);
+  return valid_p;
+}
+
+/// Validate a condition, dropping the ranges it found - a condition only selects other schemas.
+template <typename F>
+bool
+condition_call(F fn, swoc::Errata &erratum, YAML::Node const &node, std::string_view const &name)
+{
+  auto mark    = IP_Ranges ? IP_Ranges->size() : 0;
+  bool valid_p = fn(erratum, node, name);
+  if (IP_Ranges) {
+    IP_Ranges->erase(IP_Ranges->begin() + mark, IP_Ranges->end());
   }
+  return valid_p;
+}
 
-  if (!root.IsMap()) {
-    return ctx.notes.error("Root node must be a map");
+[[maybe_unused]] bool is_ipv4_format(YAML::Node const& node) {
+  swoc::IP4Addr addr;
+  return addr.load(node.Scalar());
+}
+
+[[maybe_unused]] bool is_ipv6_format(YAML::Node const& node) {
+  swoc::IP6Addr addr;
+  return addr.load(node.Scalar());
+}
+
+[[maybe_unused]] bool is_ip_address_format(YAML::Node const& node) {
+  swoc::IPAddr addr;
+  return addr.load(node.Scalar());
+}
+
+[[maybe_unused]] bool is_ip_range_format(YAML::Node const& node) {
+  if (node.IsSequence()) {
+    // The minimum and maximum addresses of the range.
+    swoc::IPAddr min, max;
+    return node.size() == 2 && node[0].IsScalar() && node[1].IsScalar() && min.load(node[0].Scalar()) &&
+           max.load(node[1].Scalar()) && min.family() == max.family() && !(max < min) &&
+           ip_range_found(swoc::IPRange{min, max}, node);
   }
+  swoc::IPRange range;
+  return range.load(node.Scalar()) && ip_range_found(range, node);
+}
 
-  ctx.src_out("#include <functional>\n#include <array>\n#include "
-              "<algorithm>\n#include <iostream>\n\n"
-              "#include \"{}\"\n\n"
-              "using Validator = std::function<bool (YAML::Node const&)>;\n",
-              ctx.hdr_path);
+[[maybe_unused]] bool is_cidr_format(YAML::Node const& node) {
+  swoc::IPRange range;
+  return node.Scalar().find('/') != std::string::npos && range.load(node.Scalar()) && ip_range_found(range, node);
+}
 
-  ctx.hdr_out("#include <string_view>\n\n#include \"swoc/Errata.h\"\n#include \"yaml-cpp/yaml.h\"\n\n");
-  ctx.hdr_out("class {} {{\npublic:\n", ctx.class_name);
-  ctx.indent_hdr();
-  ctx.hdr_out("swoc::Errata erratum;\n");
-  ctx.hdr_out("bool operator()(const YAML::Node &n);\n\n", ctx.class_name);
+} // namespace
 
-  // These are hand rolled functions used by the generated code.
-  ctx.src_file << (R"racecar(
-namespace {
+)racecar");
+  } else {
+    // Without IP formats there is nothing to drop for a branch or condition.
+    ctx.src_file << (R"racecar(namespace {
 
+template <typename F>
 bool
-equal(const YAML::Node &lhs, const YAML::Node &rhs)
+branch_call(F fn, swoc::Errata &erratum, YAML::Node const &node, std::string_view const &name)
 {
-  if (lhs.Type() == rhs.Type()) {
-    if (lhs.IsSequence()) {
-      if (lhs.size() != rhs.size()) {
-        return false;
-      }
-      for (int i = 0, n = lhs.size(); i < n; ++i) {
-        if (!equal(lhs[i], rhs[i])) {
+  return fn(erratum, node, name);
+}
+
+template <typename F>
+bool
+condition_call(F fn, swoc::Errata &erratum, YAML::Node const &node, std::string_view const &name)
+{
+  return fn(erratum, node, name);
+}
+
+} // namespace
+
+)racecar");
+  }
+
+  if (ctx.text_format_p) {
+    ctx.src_file << (R"racecar(namespace {
+
+// Character classes for the format scanners.
+constexpr uint8_t CC_ALPHA     = 1 << 0;
+constexpr uint8_t CC_DIGIT     = 1 << 1;
+constexpr uint8_t CC_HEX       = 1 << 2;
+constexpr uint8_t CC_SCHEME    = 1 << 3; ///< Not alphanumeric but valid in a URI scheme.
+constexpr uint8_t CC_UNRESERVED = 1 << 4; ///< Not alphanumeric but unreserved in a URI.
+constexpr uint8_t CC_SUB_DELIM = 1 << 5;
+constexpr uint8_t CC_PCHAR     = 1 << 6; ///< Not otherwise classified but valid in a URI path segment.
+
+constexpr std::array<uint8_t, 256> Char_Class = []() {
+  std::array<uint8_t, 256> table{};
+  for (int c = 0; c < 256; ++c) {
+    if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z')) {
+      table[c] |= CC_ALPHA;
+    }
+    if ('0' <= c && c <= '9') {
+      table[c] |= CC_DIGIT | CC_HEX;
+    }
+    if (('a' <= c && c <= 'f') || ('A' <= c && c <= 'F')) {
+      table[c] |= CC_HEX;
+    }
+  }
+  for (unsigned char c : std::string_view{"+-."}) {
+    table[c] |= CC_SCHEME;
+  }
+  for (unsigned char c : std::string_view{"-._~"}) {
+    table[c] |= CC_UNRESERVED;
+  }
+  for (unsigned char c : std::string_view{"!$&'()*+,;="}) {
+    table[c] |= CC_SUB_DELIM;
+  }
+  for (unsigned char c : std::string_view{":@"}) {
+    table[c] |= CC_PCHAR;
+  }
+  return table;
+}();
+
+constexpr uint8_t CC_ALNUM = CC_ALPHA | CC_DIGIT;
+constexpr uint8_t CC_URI   = CC_ALNUM | CC_UNRESERVED | CC_SUB_DELIM | CC_PCHAR;
+
+// RFC 1123 host name - dot separated labels of alphanumerics and interior dashes.
+bool
+hostname_scan(std::string_view text)
+{
+  if (text.empty() || text.size() > 253) {
+    return false;
+  }
+  size_t label = 0;
+  char prev    = '.';
+  for (char c : text) {
+    if (Char_Class[static_cast<unsigned char>(c)] & CC_ALNUM) {
+      ++label;
+    } else if (c == '-' && label > 0) {
+      ++label;
+    } else if (c == '.' && label > 0 && prev != '-') {
+      label = 0;
+    } else {
+      return false;
+    }
+    if (label > 63) {
+      return false;
+    }
+    prev = c;
+  }
+  return label > 0 && prev != '-';
+}
+
+// RFC 3986 URI if @a scheme_p, otherwise URI reference.
+bool
+uri_scan(std::string_view text, bool scheme_p)
+{
+  size_t idx = 0;
+  size_t n   = text.size();
+  auto cc    = [&](size_t i) { return Char_Class[static_cast<unsigned char>(text[i])]; };
+  auto pct   = [&]() { // check for a valid percent encoding at @a idx.
+    if (idx + 2 < n && (cc(idx + 1) & CC_HEX) && (cc(idx + 2) & CC_HEX)) {
+      idx += 3;
+      return true;
+    }
+    return false;
+  };
+
+  if (n > 0 && (cc(0) & CC_ALPHA)) {
+    while (idx < n && (cc(idx) & (CC_ALNUM | CC_SCHEME))) {
+      ++idx;
+    }
+  }
+  // The scheme must be non-empty - a leading ':' is not a scheme delimiter.
+  if (idx > 0 && idx < n && text[idx] == ':') {
+    ++idx;
+  } else if (scheme_p) {
+    return false;
+  } else {
+    // Relative reference - the first path segment can't contain a colon.
+    idx = 0;
+    auto end = text.find_first_of("/?#");
+    if (text.substr(0, end).find(':') != std::string_view::npos) {
+      return false;
+    }
+  }
+
+  if (text.substr(idx, 2) == "//") { // authority
+    idx += 2;
+    bool literal_p = false;
+    while (idx < n && text[idx] != '/' && text[idx] != '?' && text[idx] != '#') {
+      char c = text[idx];
+      if (c == '%') {
+        if (!pct()) {
           return false;
         }
-        return true;
+        continue;
+      } else if (c == '[' && !literal_p) {
+        literal_p = true;
+      } else if (c == ']' && literal_p) {
+        literal_p = false;
+      } else if (!(cc(idx) & CC_URI)) {
+        return false;
       }
-    } else if (lhs.IsMap()) {
-      if (lhs.size() != rhs.size()) {
+      ++idx;
+    }
+    if (literal_p) {
+      return false;
+    }
+  }
+
+  bool fragment_p = false;
+  while (idx < n) {
+    char c = text[idx];
+    if (c == '%') {
+      if (!pct()) {
         return false;
       }
-      for (const auto &pair : lhs) {
-        auto key   = pair.first;
-        auto value = pair.second;
-        if (!rhs[key] || !equal(value, rhs[key])) {
-          return false;
-        }
-        return true;
+      continue;
+    } else if (c == '#') {
+      if (fragment_p) {
+        return false;
       }
-    } else {
-      return lhs.Scalar() == rhs.Scalar();
+      fragment_p = true;
+    } else if (c != '/' && c != '?' && !(cc(idx) & CC_URI)) {
+      return false;
     }
+    ++idx;
   }
-  return false;
+  return true;
 }
 
-bool is_null_type(YAML::Node const& node) {
-  return node.IsNull();
+[[maybe_unused]] bool is_hostname_format(YAML::Node const& node) {
+  return hostname_scan(node.Scalar());
 }
 
-bool is_bool_type(YAML::Node const& node) {
-  if (node.IsScalar()) {
-    auto && value { node.Scalar() };
-    return 0 == strcasecmp("true", value) || 0 == strcasecmp("false", value);
+// Host name with an optional leading wildcard label, and an optional trailing dot for the root.
+[[maybe_unused]] bool is_fqdn_format(YAML::Node const& node) {
+  std::string_view text{node.Scalar()};
+  if (text.size() > 2 && text[0] == '*' && text[1] == '.') {
+    text.remove_prefix(2);
   }
-  return false;
+  if (!text.empty() && text.back() == '.') {
+    text.remove_suffix(1);
+  }
+  return hostname_scan(text);
 }
 
-bool is_array_type(YAML::Node const& node) {
-  return node.IsSequence();
+[[maybe_unused]] bool is_uri_format(YAML::Node const& node) {
+  return uri_scan(node.Scalar(), true);
 }
 
-bool is_object_type(YAML::Node const& node) {
-  return node.IsMap();
+[[maybe_unused]] bool is_uri_reference_format(YAML::Node const& node) {
+  return uri_scan(node.Scalar(), false);
 }
 
-bool is_integer_type(YAML::Node const& node) {
-  if (node.IsScalar()) {
-    swoc::TextView value { node.Scalar() };
-    swoc::TextView parsed;
-    if (value.trim_if(&isspace).size() < 1) {
+} // namespace
+
+)racecar");
+  }
+
+  if (ctx.decoded_size_p) {
+    ctx.src_file << (R"racecar(namespace {
+
+constexpr uint64_t LOW_BITS  = 0x0101010101010101ULL;
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+// Mark the bytes in @a w equal to @a c with their high bit. Bytes above a match may be marked as well.
+inline uint64_t
+swar_find(uint64_t w, char c)
+{
+  uint64_t v = w ^ (LOW_BITS * static_cast<uint8_t>(c));
+  return (v - LOW_BITS) & ~v & HIGH_BITS;
+}
+
+inline bool
+is_hex_digit(char c)
+{
+  return ('0' <= c && c <= '9') || ('a' <= c && c <= 'f') || ('A' <= c && c <= 'F');
+}
+
+// Size of @a text after URI decoding. Only '%' followed by two hex digits is an escape.
+int64_t
+uri_decoded_size(std::string_view text)
+{
+  auto s       = text.data();
+  size_t n     = text.size();
+  size_t i     = 0;
+  int64_t size = n;
+  auto check   = [&](size_t p) {
+    if (s[p] == '%' && p + 2 < n && is_hex_digit(s[p + 1]) && is_hex_digit(s[p + 2])) {
+      size -= 2;
+    }
+  };
+  for (; i + 8 <= n; i += 8) {
+    uint64_t w;
+    memcpy(&w, s + i, sizeof(w));
+    if (swar_find(w, '%')) {
+      for (size_t k = 0; k < 8; ++k) {
+        check(i + k);
+      }
+    }
+  }
+  for (; i < n; ++i) {
+    check(i);
+  }
+  return size;
+}
+
+// Size of @a text after decoding JSON string escapes, or -1 if an escape is invalid.
+int64_t
+esc_json_decoded_size(std::string_view text)
+{
+  auto s       = text.data();
+  size_t n     = text.size();
+  size_t i     = 0;
+  int64_t size = n;
+  auto hex4    = [&](size_t p, unsigned &cp) -> bool {
+    if (p + 4 > n) {
       return false;
     }
-    swoc::svtoi(value, &parsed);
-    return value.size() == parsed.size();
+    auto [ptr, ec] = std::from_chars(s + p, s + p + 4, cp, 16);
+    return ec == std::errc{} && ptr == s + p + 4;
+  };
+  while (i < n) {
+    // Skip to the next backslash a word at a time.
+    while (i + 8 <= n) {
+      uint64_t w;
+      memcpy(&w, s + i, sizeof(w));
+      if (swar_find(w, '\\')) {
+        break;
+      }
+      i += 8;
+    }
+    for (; i < n && s[i] != '\\'; ++i)
+      ;
+    if (i + 1 >= n) {
+      return i < n ? -1 : size;
+    }
+    switch (s[i + 1]) {
+    case '"':
+    case '\\':
+    case '/':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+      size -= 1;
+      i    += 2;
+      break;
+    case 'u': {
+      unsigned cp;
+      if (!hex4(i + 2, cp)) {
+        return -1;
+      }
+      unsigned low;
+      if (0xD800 <= cp && cp <= 0xDBFF && i + 12 <= n && s[i + 6] == '\\' && s[i + 7] == 'u' && hex4(i + 8, low) && 0xDC00 <= low &&
+          low <= 0xDFFF) {
+        size -= 12 - 4; // surrogate pair
+        i    += 12;
+      } else {
+        size -= 6 - (cp < 0x80 ? 1 : cp < 0x800 ? 2 : 3);
+        i    += 6;
+      }
+      break;
+    }
+    default:
+      return -1;
+    }
   }
-  return false;
+  return size;
 }
 
-bool is_string_type(YAML::Node const& node) {
-  return node.IsScalar();
+// Size of @a text after decoding per @a encoding, or -1 if it is not valid. Unknown encodings are
+// treated as plain - the encoding value is checked by its schema.
+int64_t
+decoded_size(std::string_view text, std::string_view encoding)
+{
+  if (encoding == "uri") {
+    return uri_decoded_size(text);
+  } else if (encoding == "esc_json") {
+    return esc_json_decoded_size(text);
+  }
+  return text.size();
 }
 
 } // namespace
 
 )racecar");
+  }
 
-  if ( auto errata { ctx.process_definitions(root) } ; ! errata.is_ok() ) {
-    return errata;
+  if (ctx.memo_p) {
+    ctx.src_file << (R"racecar(namespace {
+
+using Validator = bool (*)(swoc::Errata &, YAML::Node const &, std::string_view const &);
+
+/// Definition results for the current validation, keyed by node position, node type and definition.
+/// Aliased nodes share a position and so are validated once for each definition.
+using MemoTable = std::pmr::unordered_map<uint64_t, bool>;
+thread_local MemoTable *Memo = nullptr;
+
+template <bool DIAG>
+bool
+memo_call(unsigned def, unsigned code, unsigned location, Validator fn, swoc::Errata &erratum, YAML::Node const &node,
+          std::string_view const &name)
+{
+  auto pos = node.Mark().pos;
+  // Only containers are expensive enough to be worth it, and nodes without a position can't be keyed.
+  // There is no table while IP ranges are collected.
+  if (!Memo || pos < 0 || !(node.IsMap() || node.IsSequence())) {
+    return fn(erratum, node, name);
+  }
+  uint64_t key = (uint64_t(pos) << 20) | (uint64_t(node.Type()) << 16) | def;
+  if (auto spot = Memo->find(key); spot != Memo->end()) {
+    if constexpr (DIAG) {
+      if (!spot->second) {
+        report(code, location, node, 0, 0);
+      }
+    }
+    return spot->second;
   }
+  bool result = fn(erratum, node, name);
+  (*Memo)[key] = result;
+  return result;
+}
 
-  ctx.exdent_hdr();
-  ctx.hdr_out("}};\n");
+} // namespace
 
-  ctx.src_out("bool {}::operator()(YAML::Node const& node) {{\n", ctx.class_name);
-  ctx.indent_src();
-  ctx.src_out("static constexpr std::string_view name {{\"root\"}};\n");
-  ctx.src_out("erratum.clear();\n\n");
-  ctx.validate_node(root, "node");
-  ctx.src_out("\nreturn erratum.severity() < swoc::Severity::ERROR;\n");
-  ctx.exdent_src();
-  ctx.src_out("}}\n");
+)racecar");
+  }
+
+  // Generated validation functions.
+  ctx.src_file << "namespace {\n" << ctx._src_decls.str() << '\n' << ctx._src_defs.str() << "} // namespace\n\n";
+  ctx.src_file << ctx._src_frames.front().text.str();
 
   return ctx.notes;
 }
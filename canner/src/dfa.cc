@@ -0,0 +1,911 @@
+/** @file
+
+    Compilation of regular expressions to deterministic finite automata.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one or more contributor license
+    agreements.  See the NOTICE file distributed with this work for additional information regarding
+    copyright ownership.  The ASF licenses this file to you under the Apache License, Version 2.0
+    (the "License"); you may not use this file except in compliance with the License.  You may
+    obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software distributed under the
+    License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+    express or implied. See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <utility>
+
+#include "dfa.h"
+
+using swoc::Errata;
+
+namespace
+{
+// Input symbols are the bytes plus markers for the start and end of the text. The anchors '^' and
+// '$' match these markers, which makes them ordinary transitions.
+constexpr unsigned BOS       = 256;
+constexpr unsigned EOS       = 257;
+constexpr unsigned N_SYMBOLS = 258;
+using SymSet                 = std::bitset<N_SYMBOLS>;
+
+// Limits to keep generation time and output size sane.
+constexpr int MAX_REPEAT        = 1000;
+constexpr size_t MAX_NFA_STATES = 100000;
+
+/// Parsed regular expression.
+struct Ast {
+  enum Kind { SET, CAT, ALT, REPEAT };
+  Kind kind = CAT; ///< An empty @c CAT matches the empty string.
+  SymSet set;      ///< Symbols for @c SET.
+  std::vector<Ast> kids;
+  int min = 0;  ///< Minimum count for @c REPEAT.
+  int max = -1; ///< Maximum count for @c REPEAT, -1 if unbounded.
+
+  static Ast
+  of(SymSet const &set)
+  {
+    Ast zret;
+    zret.kind = SET;
+    zret.set  = set;
+    return zret;
+  }
+
+  static Ast
+  of(unsigned c)
+  {
+    SymSet set;
+    set[c] = true;
+    return of(set);
+  }
+
+  /// Literal sequence of bytes.
+  static Ast
+  of(std::string_view bytes)
+  {
+    Ast zret;
+    for (unsigned char c : bytes) {
+      zret.kids.push_back(of(c));
+    }
+    return zret;
+  }
+};
+
+SymSet
+byte_range(unsigned lo, unsigned hi)
+{
+  SymSet zret;
+  for (auto c = lo; c <= hi; ++c) {
+    zret[c] = true;
+  }
+  return zret;
+}
+
+/// Any single non-ASCII UTF-8 encoded code point.
+Ast
+any_utf8()
+{
+  auto tail = Ast::of(byte_range(0x80, 0xBF));
+  Ast zret;
+  zret.kind = Ast::ALT;
+  for (auto [lo, hi, n] : {std::tuple{0xC2U, 0xDFU, 1}, {0xE0U, 0xEFU, 2}, {0xF0U, 0xF4U, 3}}) {
+    Ast seq;
+    seq.kids.push_back(Ast::of(byte_range(lo, hi)));
+    seq.kids.insert(seq.kids.end(), n, tail);
+    zret.kids.push_back(std::move(seq));
+  }
+  return zret;
+}
+
+/// UTF-8 encoding of @a cp.
+std::string
+utf8(unsigned cp)
+{
+  std::string zret;
+  if (cp < 0x80) {
+    zret += char(cp);
+  } else if (cp < 0x800) {
+    zret += char(0xC0 | (cp >> 6));
+    zret += char(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    zret += char(0xE0 | (cp >> 12));
+    zret += char(0x80 | ((cp >> 6) & 0x3F));
+    zret += char(0x80 | (cp & 0x3F));
+  } else {
+    zret += char(0xF0 | (cp >> 18));
+    zret += char(0x80 | ((cp >> 12) & 0x3F));
+    zret += char(0x80 | ((cp >> 6) & 0x3F));
+    zret += char(0x80 | (cp & 0x3F));
+  }
+  return zret;
+}
+
+/// A character class.
+struct Chars {
+  std::bitset<128> ascii;         ///< ASCII members.
+  bool non_ascii_p = false;       ///< All non-ASCII code points are members.
+  std::vector<std::string> seqs;  ///< Specific non-ASCII members, UTF-8 encoded.
+
+  Chars &
+  add(Chars const &that)
+  {
+    ascii |= that.ascii;
+    non_ascii_p = non_ascii_p || that.non_ascii_p;
+    seqs.insert(seqs.end(), that.seqs.begin(), that.seqs.end());
+    return *this;
+  }
+
+  Chars &
+  invert()
+  {
+    ascii       = ~ascii;
+    non_ascii_p = !non_ascii_p;
+    return *this;
+  }
+
+  Ast
+  ast() const
+  {
+    Ast zret;
+    zret.kind = Ast::ALT;
+    SymSet set;
+    for (unsigned c = 0; c < 128; ++c) {
+      set[c] = ascii[c];
+    }
+    zret.kids.push_back(Ast::of(set));
+    if (non_ascii_p) {
+      zret.kids.push_back(any_utf8());
+    }
+    for (auto const &seq : seqs) {
+      zret.kids.push_back(Ast::of(seq));
+    }
+    return zret;
+  }
+};
+
+Chars
+ascii_chars(std::string_view members)
+{
+  Chars zret;
+  for (unsigned char c : members) {
+    zret.ascii[c] = true;
+  }
+  return zret;
+}
+
+Chars
+ascii_range(unsigned lo, unsigned hi)
+{
+  Chars zret;
+  for (auto c = lo; c <= hi; ++c) {
+    zret.ascii[c] = true;
+  }
+  return zret;
+}
+
+Chars
+digit_chars()
+{
+  return ascii_range('0', '9');
+}
+
+Chars
+word_chars()
+{
+  return ascii_range('a', 'z').add(ascii_range('A', 'Z')).add(digit_chars()).add(ascii_chars("_"));
+}
+
+Chars
+space_chars()
+{
+  return ascii_chars(" \t\n\r\f\v");
+}
+
+/// Recursive descent parser for a pattern.
+class Parser
+{
+public:
+  explicit Parser(std::string_view text) : _text(text) {}
+
+  /// Parse the pattern. Check @a _error for failure.
+  Ast
+  parse()
+  {
+    auto zret = this->alternation();
+    if (_error.empty() && _idx < _text.size()) {
+      this->fail("unmatched ')'");
+    }
+    return zret;
+  }
+
+  std::string _error; ///< Description of the first error.
+  size_t _idx = 0;    ///< Parse position.
+
+protected:
+  std::string_view _text;
+
+  bool
+  ok() const
+  {
+    return _error.empty();
+  }
+
+  bool
+  at_end() const
+  {
+    return _idx >= _text.size();
+  }
+
+  char
+  peek() const
+  {
+    return _text[_idx];
+  }
+
+  void
+  fail(std::string_view msg)
+  {
+    if (_error.empty()) {
+      _error = msg;
+    }
+  }
+
+  Ast alternation();
+  Ast sequence();
+  Ast atom();
+  bool quantifier(int &min, int &max);
+  bool number(int &n);
+  Chars char_class();
+  /// Parse an escape, with the leading backslash already consumed.
+  Chars escape(bool class_p, bool &single_p, unsigned &cp);
+  /// Parse a UTF-8 encoded code point in the pattern.
+  unsigned code_point();
+};
+
+Ast
+Parser::alternation()
+{
+  Ast zret = this->sequence();
+  if (ok() && !at_end() && peek() == '|') {
+    Ast alt;
+    alt.kind = Ast::ALT;
+    alt.kids.push_back(std::move(zret));
+    while (ok() && !at_end() && peek() == '|') {
+      ++_idx;
+      alt.kids.push_back(this->sequence());
+    }
+    zret = std::move(alt);
+  }
+  return zret;
+}
+
+Ast
+Parser::sequence()
+{
+  Ast zret;
+  while (ok() && !at_end() && peek() != '|' && peek() != ')') {
+    Ast item = this->atom();
+    int min, max;
+    while (ok() && this->quantifier(min, max)) {
+      Ast rep;
+      rep.kind = Ast::REPEAT;
+      rep.min  = min;
+      rep.max  = max;
+      rep.kids.push_back(std::move(item));
+      item = std::move(rep);
+    }
+    zret.kids.push_back(std::move(item));
+  }
+  return zret;
+}
+
+bool
+Parser::number(int &n)
+{
+  size_t start = _idx;
+  n            = 0;
+  while (!at_end() && '0' <= peek() && peek() <= '9') {
+    n = std::min(n * 10 + (peek() - '0'), MAX_REPEAT + 1);
+    ++_idx;
+  }
+  return _idx > start;
+}
+
+bool
+Parser::quantifier(int &min, int &max)
+{
+  if (at_end()) {
+    return false;
+  }
+  switch (peek()) {
+  case '*':
+    min = 0, max = -1;
+    break;
+  case '+':
+    min = 1, max = -1;
+    break;
+  case '?':
+    min = 0, max = 1;
+    break;
+  case '{': {
+    // If it's not a valid quantifier, the brace is a literal.
+    size_t save = _idx++;
+    if (!this->number(min)) {
+      _idx = save;
+      return false;
+    }
+    max = min;
+    if (!at_end() && peek() == ',') {
+      ++_idx;
+      if (!this->number(max)) {
+        max = -1;
+      }
+    }
+    if (at_end() || peek() != '}') {
+      _idx = save;
+      return false;
+    }
+    if (min > MAX_REPEAT || max > MAX_REPEAT) {
+      this->fail("repeat count is too large");
+    } else if (max >= 0 && max < min) {
+      this->fail("repeat count range is out of order");
+    }
+    break;
+  }
+  default:
+    return false;
+  }
+  ++_idx;
+  // Lazy quantifiers match the same language.
+  if (!at_end() && peek() == '?') {
+    ++_idx;
+  }
+  return true;
+}
+
+unsigned
+Parser::code_point()
+{
+  unsigned char c = peek();
+  int n           = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+  if (n == 0 || _idx + n >= _text.size()) {
+    this->fail("invalid UTF-8");
+    ++_idx;
+    return 0;
+  }
+  unsigned cp = c & (0x3F >> n);
+  for (++_idx; n > 0; --n, ++_idx) {
+    cp = (cp << 6) | (static_cast<unsigned char>(peek()) & 0x3F);
+  }
+  return cp;
+}
+
+Chars
+Parser::escape(bool class_p, bool &single_p, unsigned &cp)
+{
+  single_p = true;
+  if (at_end()) {
+    this->fail("trailing '\\'");
+    return {};
+  }
+  char c = _text[_idx++];
+  auto hex = [&](int n) -> unsigned {
+    unsigned zret = 0;
+    for (; n > 0; --n, ++_idx) {
+      char h = at_end() ? 0 : peek();
+      if ('0' <= h && h <= '9') {
+        zret = zret * 16 + (h - '0');
+      } else if ('a' <= (h | 0x20) && (h | 0x20) <= 'f') {
+        zret = zret * 16 + ((h | 0x20) - 'a' + 10);
+      } else {
+        this->fail("invalid hexadecimal escape");
+        return 0;
+      }
+    }
+    return zret;
+  };
+  single_p = false;
+  switch (c) {
+  case 'd':
+    return digit_chars();
+  case 'D':
+    return digit_chars().invert();
+  case 'w':
+    return word_chars();
+  case 'W':
+    return word_chars().invert();
+  case 's':
+    return space_chars();
+  case 'S':
+    return space_chars().invert();
+  default:
+    break;
+  }
+  single_p = true;
+  switch (c) {
+  case 't':
+    cp = '\t';
+    break;
+  case 'n':
+    cp = '\n';
+    break;
+  case 'r':
+    cp = '\r';
+    break;
+  case 'f':
+    cp = '\f';
+    break;
+  case 'v':
+    cp = '\v';
+    break;
+  case '0':
+    cp = 0;
+    break;
+  case 'x':
+    cp = hex(2);
+    break;
+  case 'u':
+    cp = hex(4);
+    if (0xD800 <= cp && cp <= 0xDFFF) {
+      this->fail("surrogate code points are not supported");
+    }
+    break;
+  case 'c':
+    if (at_end() || !isalpha(static_cast<unsigned char>(peek()))) {
+      this->fail("invalid control escape");
+    } else {
+      cp = _text[_idx++] % 32;
+    }
+    break;
+  case 'b':
+    if (class_p) {
+      cp = '\b';
+    } else {
+      this->fail("word boundaries are not supported");
+    }
+    break;
+  case 'B':
+    this->fail("word boundaries are not supported");
+    break;
+  default:
+    if ('1' <= c && c <= '9') {
+      this->fail("back references are not supported");
+    } else if (static_cast<unsigned char>(c) >= 0x80) {
+      --_idx;
+      cp = this->code_point();
+    } else {
+      cp = static_cast<unsigned char>(c);
+    }
+    break;
+  }
+  Chars zret;
+  if (cp < 0x80) {
+    zret.ascii[cp] = true;
+  } else {
+    zret.seqs.push_back(utf8(cp));
+  }
+  return zret;
+}
+
+Chars
+Parser::char_class()
+{
+  Chars zret;
+  bool invert_p = false;
+  if (!at_end() && peek() == '^') {
+    invert_p = true;
+    ++_idx;
+  }
+  // Read a single class member, returning the code point if it is a single character.
+  auto member = [&](bool &single_p, unsigned &cp) -> Chars {
+    char c   = peek();
+    single_p = true;
+    if (c == '\\') {
+      ++_idx;
+      return this->escape(true, single_p, cp);
+    }
+    Chars chars;
+    if (static_cast<unsigned char>(c) >= 0x80) {
+      cp = this->code_point();
+      chars.seqs.push_back(utf8(cp));
+    } else {
+      cp = c;
+      ++_idx;
+      chars.ascii[cp] = true;
+    }
+    return chars;
+  };
+
+  while (ok() && !at_end() && peek() != ']') {
+    bool lo_single_p, hi_single_p;
+    unsigned lo, hi;
+    auto chars = member(lo_single_p, lo);
+    if (ok() && lo_single_p && _idx + 1 < _text.size() && peek() == '-' && _text[_idx + 1] != ']') {
+      ++_idx;
+      member(hi_single_p, hi);
+      if (!hi_single_p) {
+        this->fail("invalid range in character class");
+      } else if (hi < lo) {
+        this->fail("range out of order in character class");
+      } else if (hi >= 0x80) {
+        this->fail("non-ASCII ranges in a character class are not supported");
+      } else {
+        chars = ascii_range(lo, hi);
+      }
+    }
+    zret.add(chars);
+  }
+  if (at_end()) {
+    this->fail("unterminated character class");
+  }
+  ++_idx;
+  if (invert_p) {
+    if (!zret.seqs.empty()) {
+      this->fail("non-ASCII characters in a negated character class are not supported");
+    }
+    zret.invert();
+  }
+  return zret;
+}
+
+Ast
+Parser::atom()
+{
+  char c = _text[_idx++];
+  switch (c) {
+  case '(': {
+    if (!at_end() && peek() == '?') {
+      ++_idx;
+      char kind = at_end() ? 0 : _text[_idx++];
+      if (kind == '<' && !at_end() && peek() != '=' && peek() != '!') {
+        // Named group - the name doesn't matter.
+        while (!at_end() && peek() != '>') {
+          ++_idx;
+        }
+        ++_idx;
+      } else if (kind != ':') {
+        this->fail("look around assertions are not supported");
+        return {};
+      }
+    }
+    Ast zret = this->alternation();
+    if (at_end() || peek() != ')') {
+      this->fail("missing ')'");
+    } else {
+      ++_idx;
+    }
+    return zret;
+  }
+  case '[':
+    return this->char_class().ast();
+  case '.':
+    return ascii_chars("\n\r").invert().ast();
+  case '^':
+    return Ast::of(BOS);
+  case '$':
+    return Ast::of(EOS);
+  case '\\': {
+    bool single_p;
+    unsigned cp;
+    return this->escape(false, single_p, cp).ast();
+  }
+  case '*':
+  case '+':
+  case '?':
+    this->fail("quantifier without a preceding item");
+    return {};
+  default:
+    break;
+  }
+  if (static_cast<unsigned char>(c) >= 0x80) {
+    --_idx;
+    return Ast::of(utf8(this->code_point()));
+  }
+  return Ast::of(static_cast<unsigned char>(c));
+}
+
+/// Nondeterministic automaton built from the parsed patterns.
+struct Nfa {
+  struct State {
+    SymSet on;             ///< Symbols for the transition to @a next.
+    int next = -1;         ///< Target for @a on.
+    std::vector<int> eps;  ///< Epsilon transitions.
+  };
+  std::vector<State> states;
+
+  int
+  add()
+  {
+    states.emplace_back();
+    return int(states.size() - 1);
+  }
+
+  /// Build the states for @a ast, returning the start and end states.
+  std::pair<int, int>
+  build(Ast const &ast)
+  {
+    if (states.size() > MAX_NFA_STATES) { // Give up - the caller checks the size.
+      int s = this->add();
+      return {s, s};
+    }
+    switch (ast.kind) {
+    case Ast::SET: {
+      int s = this->add(), e = this->add();
+      states[s].on   = ast.set;
+      states[s].next = e;
+      return {s, e};
+    }
+    case Ast::CAT: {
+      int s = this->add(), e = s;
+      for (auto const &kid : ast.kids) {
+        auto [ks, ke] = this->build(kid);
+        states[e].eps.push_back(ks);
+        e = ke;
+      }
+      return {s, e};
+    }
+    case Ast::ALT: {
+      int s = this->add(), e = this->add();
+      for (auto const &kid : ast.kids) {
+        auto [ks, ke] = this->build(kid);
+        states[s].eps.push_back(ks);
+        states[ke].eps.push_back(e);
+      }
+      return {s, e};
+    }
+    case Ast::REPEAT: {
+      int s = this->add(), cur = s;
+      for (int i = 0; i < ast.min; ++i) {
+        auto [ks, ke] = this->build(ast.kids[0]);
+        states[cur].eps.push_back(ks);
+        cur = ke;
+      }
+      int e = this->add();
+      if (ast.max < 0) {
+        auto [ks, ke] = this->build(ast.kids[0]);
+        states[cur].eps.push_back(ks);
+        states[cur].eps.push_back(e);
+        states[ke].eps.push_back(cur);
+      } else {
+        for (int i = ast.min; i < ast.max; ++i) {
+          auto [ks, ke] = this->build(ast.kids[0]);
+          states[cur].eps.push_back(e);
+          states[cur].eps.push_back(ks);
+          cur = ke;
+        }
+        states[cur].eps.push_back(e);
+      }
+      return {s, e};
+    }
+    }
+    return {0, 0};
+  }
+
+  /// Extend @a set to its epsilon closure, which is returned sorted.
+  void
+  closure(std::vector<int> &set) const
+  {
+    std::vector<bool> mark(states.size());
+    std::vector<int> stack{set};
+    set.clear();
+    while (!stack.empty()) {
+      int s = stack.back();
+      stack.pop_back();
+      if (!mark[s]) {
+        mark[s] = true;
+        set.push_back(s);
+        stack.insert(stack.end(), states[s].eps.begin(), states[s].eps.end());
+      }
+    }
+    std::sort(set.begin(), set.end());
+  }
+};
+
+} // namespace
+
+Errata
+Dfa::compile(std::vector<std::string> const &patterns)
+{
+  Errata zret;
+  if (patterns.size() > MAX_PATTERNS) {
+    return zret.error("Too many patterns ({}) - the limit is {}.", patterns.size(), MAX_PATTERNS);
+  }
+
+  // Every pattern is a search, so the start state loops on all input and the accept state for each
+  // pattern loops on all input after a match.
+  Nfa nfa;
+  int start                 = nfa.add();
+  nfa.states[start].on.set();
+  nfa.states[start].next = start;
+  std::vector<int> accept_states;
+  for (auto const &pattern : patterns) {
+    Parser parser{pattern};
+    auto ast = parser.parse();
+    if (!parser._error.empty()) {
+      zret.error(R"(Invalid pattern "{}" at offset {} - {}.)", pattern, parser._idx, parser._error);
+      continue;
+    }
+    auto [s, e] = nfa.build(ast);
+    int accept  = nfa.add();
+    nfa.states[start].eps.push_back(s);
+    nfa.states[e].eps.push_back(accept);
+    nfa.states[accept].on.set();
+    nfa.states[accept].next = accept;
+    accept_states.push_back(accept);
+  }
+  if (!zret.is_ok()) {
+    return zret;
+  }
+  if (nfa.states.size() > MAX_NFA_STATES) {
+    return zret.error("Patterns are too complex to compile.");
+  }
+
+  // Partition the symbols in to classes, where all symbols in a class have the same transitions.
+  std::vector<unsigned> sym_class(N_SYMBOLS);
+  std::vector<unsigned> class_rep; // Representative symbol for each class.
+  {
+    std::vector<SymSet const *> sets;
+    for (auto const &state : nfa.states) {
+      if (state.next >= 0 && std::none_of(sets.begin(), sets.end(), [&](auto set) { return *set == state.on; })) {
+        sets.push_back(&state.on);
+      }
+    }
+    std::map<std::vector<bool>, unsigned> signatures;
+    for (unsigned c = 0; c < N_SYMBOLS; ++c) {
+      std::vector<bool> sig;
+      for (auto set : sets) {
+        sig.push_back((*set)[c]);
+      }
+      auto [spot, added_p] = signatures.emplace(std::move(sig), class_rep.size());
+      if (added_p) {
+        class_rep.push_back(c);
+      }
+      sym_class[c] = spot->second;
+    }
+  }
+  unsigned n_sym_classes = class_rep.size();
+
+  // Subset construction.
+  std::map<std::vector<int>, unsigned> ids;
+  std::vector<std::vector<int>> sets;
+  std::vector<unsigned> delta;
+  std::vector<uint64_t> masks;
+  auto intern = [&](std::vector<int> &&set) -> unsigned {
+    nfa.closure(set);
+    auto [spot, added_p] = ids.emplace(set, sets.size());
+    if (added_p) {
+      uint64_t mask = 0;
+      for (size_t i = 0; i < accept_states.size(); ++i) {
+        if (std::binary_search(set.begin(), set.end(), accept_states[i])) {
+          mask |= uint64_t(1) << i;
+        }
+      }
+      masks.push_back(mask);
+      sets.push_back(std::move(set));
+    }
+    return spot->second;
+  };
+  intern({start});
+  for (size_t idx = 0; idx < sets.size(); ++idx) {
+    if (sets.size() > MAX_STATES * 4) {
+      return zret.error("Patterns are too complex to compile - more than {} states.", MAX_STATES);
+    }
+    for (unsigned k = 0; k < n_sym_classes; ++k) {
+      std::vector<int> next;
+      for (int s : sets[idx]) {
+        if (nfa.states[s].next >= 0 && nfa.states[s].on[class_rep[k]]) {
+          next.push_back(nfa.states[s].next);
+        }
+      }
+      auto target = intern(std::move(next));
+      delta.push_back(target);
+    }
+  }
+  auto step = [&](unsigned s, unsigned sym) { return delta[s * n_sym_classes + sym_class[sym]]; };
+
+  // The text is always preceded by BOS and followed by EOS, so those transitions can be done here.
+  // The result of a state is the set of patterns matched after EOS.
+  unsigned first = step(0, BOS);
+  std::vector<uint64_t> result(sets.size());
+  for (size_t s = 0; s < sets.size(); ++s) {
+    result[s] = masks[step(s, EOS)];
+  }
+
+  // States reachable from the start using only bytes.
+  std::vector<int> reachable(sets.size(), -1);
+  std::vector<unsigned> live{first};
+  reachable[first] = 0;
+  for (size_t idx = 0; idx < live.size(); ++idx) {
+    for (unsigned c = 0; c < 256; ++c) {
+      auto t = step(live[idx], c);
+      if (reachable[t] < 0) {
+        reachable[t] = live.size();
+        live.push_back(t);
+      }
+    }
+  }
+
+  // Minimize by partition refinement, starting from the results.
+  std::vector<unsigned> part(live.size());
+  size_t n_parts = 0;
+  {
+    std::map<uint64_t, unsigned> initial;
+    for (size_t i = 0; i < live.size(); ++i) {
+      part[i] = initial.emplace(result[live[i]], initial.size()).first->second;
+    }
+    n_parts = initial.size();
+  }
+  while (true) {
+    std::map<std::vector<unsigned>, unsigned> refined;
+    std::vector<unsigned> next_part(live.size());
+    for (size_t i = 0; i < live.size(); ++i) {
+      std::vector<unsigned> sig{part[i]};
+      for (unsigned k = 0; k < n_sym_classes; ++k) {
+        sig.push_back(part[reachable[delta[live[i] * n_sym_classes + k]]]);
+      }
+      next_part[i] = refined.emplace(std::move(sig), refined.size()).first->second;
+    }
+    part.swap(next_part);
+    if (refined.size() == n_parts) {
+      break;
+    }
+    n_parts = refined.size();
+  }
+  if (n_parts > MAX_STATES) {
+    return zret.error("Patterns are too complex to compile - more than {} states.", MAX_STATES);
+  }
+
+  // Transitions for the minimal states, then group bytes by identical columns.
+  std::vector<std::array<unsigned, 256>> table(n_parts);
+  std::vector<uint64_t> part_result(n_parts);
+  for (size_t i = 0; i < live.size(); ++i) {
+    part_result[part[i]] = result[live[i]];
+    for (unsigned c = 0; c < 256; ++c) {
+      table[part[i]][c] = part[reachable[step(live[i], c)]];
+    }
+  }
+
+  // Order the states so the sinks are last.
+  std::vector<unsigned> order;
+  std::vector<unsigned> sinks;
+  for (unsigned p = 0; p < n_parts; ++p) {
+    bool sink_p = std::all_of(table[p].begin(), table[p].end(), [=](unsigned t) { return t == p; });
+    (sink_p ? sinks : order).push_back(p);
+  }
+  _sink = order.size();
+  order.insert(order.end(), sinks.begin(), sinks.end());
+  std::vector<unsigned> renum(n_parts);
+  for (unsigned i = 0; i < n_parts; ++i) {
+    renum[order[i]] = i;
+  }
+
+  std::map<std::vector<unsigned>, unsigned> columns;
+  for (unsigned c = 0; c < 256; ++c) {
+    std::vector<unsigned> column;
+    for (auto p : order) {
+      column.push_back(renum[table[p][c]]);
+    }
+    auto [spot, added_p] = columns.emplace(std::move(column), columns.size());
+    _classes[c]          = spot->second;
+  }
+  _n_classes = columns.size();
+  _delta.assign(n_parts * _n_classes, 0);
+  for (auto const &[column, k] : columns) {
+    for (unsigned s = 0; s < n_parts; ++s) {
+      _delta[s * _n_classes + k] = column[s];
+    }
+  }
+  _accept.resize(n_parts);
+  for (unsigned i = 0; i < n_parts; ++i) {
+    _accept[i] = part_result[order[i]];
+  }
+  _start = renum[part[0]];
+  return zret;
+}
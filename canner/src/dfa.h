@@ -0,0 +1,68 @@
+/** @file
+
+    Compilation of regular expressions to deterministic finite automata.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one or more contributor license
+    agreements.  See the NOTICE file distributed with this work for additional information regarding
+    copyright ownership.  The ASF licenses this file to you under the Apache License, Version 2.0
+    (the "License"); you may not use this file except in compliance with the License.  You may
+    obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software distributed under the
+    License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+    express or implied. See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "swoc/Errata.h"
+
+/** A deterministic automaton that matches a set of regular expressions.
+ *
+ * The patterns are the subset of ECMA 262 regular expressions that is regular - no back references
+ * or look around. Patterns are searches, i.e. a pattern matches if it matches any part of the text
+ * unless it is anchored with '^' or '$'. The automaton is run over the bytes of the text and at the
+ * end the state determines which patterns matched.
+ *
+ * Non-ASCII text is treated as UTF-8 - '.' and negated character classes match a single code point.
+ */
+class Dfa {
+public:
+  /// Maximum number of patterns in a single automaton.
+  static constexpr size_t MAX_PATTERNS = 64;
+  /// Maximum number of states in an automaton.
+  static constexpr size_t MAX_STATES = 4096;
+
+  /** Compile @a patterns into the automaton.
+   *
+   * @param patterns The regular expressions.
+   * @return Errors for any pattern that could not be compiled.
+   *
+   * Pattern @c i is represented by bit @c i in the accept masks.
+   */
+  swoc::Errata compile(std::vector<std::string> const &patterns);
+
+  /// Map from input byte to the input class.
+  std::array<uint8_t, 256> _classes;
+  unsigned _n_classes = 0; ///< Number of distinct input classes.
+  /// Transition table, indexed by state * @a _n_classes + class.
+  std::vector<unsigned> _delta;
+  std::vector<uint64_t> _accept; ///< Patterns matched if the text ends in the state.
+  unsigned _start = 0;           ///< Initial state.
+  /// States at or above this index transition only to themselves, so matching can stop.
+  unsigned _sink = 0;
+
+  /// Number of states.
+  size_t size() const { return _accept.size(); }
+};
@@ -1,34 +1,41 @@
+#include <algorithm>
+
 #include "yaml-cpp/yaml.h"
 
 bool
 equal(const YAML::Node &lhs, const YAML::Node &rhs)
 {
-  if (lhs.Type() == rhs.Type()) {
-    if (lhs.IsSequence()) {
-      if (lhs.size() != rhs.size()) {
+  if (lhs.Type() != rhs.Type()) {
+    return false;
+  }
+  if (lhs.IsSequence()) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    for (auto l = lhs.begin(), r = rhs.begin(); l != lhs.end(); ++l, ++r) {
+      if (!equal(*l, *r)) {
         return false;
       }
-      for (int i = 0, n = lhs.size(); i < n; ++i) {
-        if (!equal(lhs[i], rhs[i])) {
+    }
+  } else if (lhs.IsMap()) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    // Keys are usually in the same order, so walk both maps and search only on a key mismatch.
+    for (auto l = lhs.begin(), r = rhs.begin(); l != lhs.end(); ++l, ++r) {
+      if (equal(l->first, r->first)) {
+        if (!equal(l->second, r->second)) {
           return false;
         }
-        return true;
-      }
-    } else if (lhs.IsMap()) {
-      if (lhs.size() != rhs.size()) {
-        return false;
-      }
-      for (const auto &pair : lhs) {
-        auto key   = pair.first;
-        auto value = pair.second;
-        if (!rhs[key] || !equal(value, rhs[key])) {
+      } else {
+        auto spot = std::find_if(rhs.begin(), rhs.end(), [&](auto const &pair) { return equal(l->first, pair.first); });
+        if (spot == rhs.end() || !equal(l->second, spot->second)) {
           return false;
         }
-        return true;
       }
-    } else {
-      return lhs.Scalar() == rhs.Scalar();
     }
+  } else if (lhs.IsScalar()) {
+    return lhs.Scalar() == rhs.Scalar();
   }
-  return false;
+  return true;
 }
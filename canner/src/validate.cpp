@@ -12,10 +12,11 @@ int main()
     TLSConfigSchema schema;
     bool valid_p = schema(config);
     std::cout << (valid_p ? "Nice job!" : "It's Leif's fault") << std::endl;
+    auto errata = schema.render();
     if (!valid_p) {
-      std::cout << schema.erratum.count() << " issues" << std::endl;
+      std::cout << errata.count() << " issues" << std::endl;
     }
-    for ( auto && note : schema.erratum ) {
+    for ( auto && note : errata ) {
       std::cout << note.text() << std::endl;
     }
   } catch (std::invalid_argument& ex) {
@@ -0,0 +1,42 @@
+/** @file
+
+    Custom check functions for the regression schemas.
+
+    @section license License
+
+    Licensed to the Apache Software Foundation (ASF) under one or more contributor license
+    agreements.  See the NOTICE file distributed with this work for additional information regarding
+    copyright ownership.  The ASF licenses this file to you under the Apache License, Version 2.0
+    (the "License"); you may not use this file except in compliance with the License.  You may
+    obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software distributed under the
+    License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+    express or implied. See the License for the specific language governing permissions and
+    limitations under the License.
+ */
+
+#pragma once
+
+#include <cctype>
+#include <string_view>
+
+#include "swoc/Errata.h"
+#include "yaml-cpp/yaml.h"
+
+namespace checks {
+/// Check the scalar is an HTTP token - letters, digits and dashes.
+inline bool
+is_token(swoc::Errata &erratum, YAML::Node const &node, std::string_view const &)
+{
+  for (char c : node.Scalar()) {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '-') {
+      erratum.error("Value '{}' at line {} is not a token.", node.Scalar(), node.Mark().line);
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace checks